@@ -0,0 +1,135 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              address_map.cpp \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#include <algorithm>
+#include "address_map.h"
+#include "debug.h"
+
+/// \return The number of trailing zero bits in x, 64 for 0
+static unsigned trailing_zeros(uint64_t x)
+{
+    if (x == 0)
+        return 64;
+    unsigned count = 0;
+    while ((x & 1) == 0)
+    {
+        x >>= 1;
+        count++;
+    }
+    return count;
+}
+
+address_map::address_map()
+{
+    this->table_base = 0;
+    this->table_shift = 0;
+}
+
+void address_map::add(uint64_t first, uint64_t last, unsigned index)
+{
+
+    check(first <= last, "An address range can not end before it starts");
+    check(index != NONE, "address_map::NONE can not be used as a range index");
+
+    // ranges added earlier win where they overlap, as they would in a
+    // linear walk in the order added, so only the parts of the new range
+    // no other range covers are kept
+    std::vector<range> pieces;
+    range r;
+    r.index = index;
+    r.first = first;
+    bool covered = false;
+    for (size_t ix = 0; ix < this->ranges.size() && !covered; ix++)
+    {
+        const range& existing = this->ranges[ix];
+        if (existing.last < r.first || existing.first > last)
+            continue;
+        if (existing.first > r.first)
+        {
+            r.last = existing.first - 1;
+            pieces.push_back(r);
+        }
+        if (existing.last >= last)
+            covered = true;
+        else
+            r.first = existing.last + 1;
+    }
+    if (!covered)
+    {
+        r.last = last;
+        pieces.push_back(r);
+    }
+
+    this->ranges.insert(this->ranges.end(), pieces.begin(), pieces.end());
+    std::sort
+    (
+        this->ranges.begin(),
+        this->ranges.end(),
+        [](const range& lhs, const range& rhs) { return lhs.first < rhs.first; }
+    );
+    this->build_table();
+
+}
+
+unsigned address_map::search(uint64_t address) const
+{
+    // find the last range starting at or before address
+    size_t low = 0;
+    size_t high = this->ranges.size();
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (this->ranges[middle].first <= address)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low == 0 || this->ranges[low - 1].last < address)
+        return NONE;
+    return this->ranges[low - 1].index;
+}
+
+void address_map::build_table()
+{
+
+    this->table.clear();
+    if (this->ranges.empty())
+        return;
+
+    // the widest power of 2 slot which every range starts and ends on,
+    // measured from the start of the first range.  Gaps between ranges
+    // start and end on a range boundary, so they line up too.
+    this->table_base = this->ranges.front().first;
+    unsigned shift = 63;
+    for (size_t ix = 0; ix < this->ranges.size(); ix++)
+    {
+        const range& r = this->ranges[ix];
+        shift = std::min(shift, trailing_zeros(r.first - this->table_base));
+        shift = std::min(shift, trailing_zeros(r.last + 1 - this->table_base));
+    }
+
+    uint64_t num_slots = ((this->ranges.back().last - this->table_base) >> shift) + 1;
+    if (num_slots > max_table_size)
+        return;
+
+    this->table_shift = shift;
+    this->table.assign((size_t)num_slots, (unsigned)NONE);
+    for (size_t ix = 0; ix < this->ranges.size(); ix++)
+    {
+        const range& r = this->ranges[ix];
+        uint64_t first_slot = (r.first - this->table_base) >> shift;
+        uint64_t last_slot = (r.last - this->table_base) >> shift;
+        for (uint64_t slot = first_slot; slot <= last_slot; slot++)
+            this->table[(size_t)slot] = r.index;
+    }
+
+}
@@ -0,0 +1,110 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              address_map.h \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#ifndef __HEADER_GUARD_ADDRESS_MAP__
+#define __HEADER_GUARD_ADDRESS_MAP__
+
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+/// \class address_map
+/// Finds which of a set of non-overlapping address ranges contains an
+/// address, for example which \ref addressable a \ref cpu sends an access
+/// to or which \ref memory module a controller forwards it to.  The
+/// ranges are kept sorted and searched with a binary search.  When every
+/// range starts and ends on a multiple of the same power of 2, as modules
+/// of equal size placed one after another do, the map also builds a table
+/// indexed by the address shifted right, so a lookup is one subtraction,
+/// one shift and one load however many ranges there are.
+///
+/// Ranges are added while the system is set up.  A range must not change
+/// after it has been added.  Where ranges overlap the one added first
+/// wins, as it would in a walk over the ranges in the order added.
+class address_map
+{
+
+    public:
+
+        address_map();
+
+        /// Returned by find() when no range contains the address
+        static const unsigned NONE = UINT_MAX;
+
+        /// Add the range first to last inclusive, which find() reports as
+        /// index.  Rebuilds the lookup table, so this is meant for setup
+        /// only.
+        void add
+        (
+            /// [in] First address in the range
+            uint64_t first,
+            /// [in] Last address in the range, which is part of it
+            uint64_t last,
+            /// [in] Caller's index for the range, usually its position in
+            /// the caller's own table of devices
+            unsigned index
+        );
+
+        /// \return The index given to add() with the range containing
+        /// address, or address_map::NONE if there is none
+        inline unsigned find(uint64_t address) const
+        {
+            if (this->table.empty())
+                return this->search(address);
+            if (address < this->table_base)
+                return NONE;
+            uint64_t slot = (address - this->table_base) >> this->table_shift;
+            return slot < this->table.size()
+                ? this->table[(size_t)slot]
+                : NONE;
+        }
+
+    protected:
+
+        /// Largest lookup table built, in entries.  Sets of ranges which
+        /// would need a bigger one are binary searched instead.
+        static const uint64_t max_table_size = 1 << 16;
+
+        /// One range given to add()
+        struct range
+        {
+            uint64_t first;
+            uint64_t last;
+            unsigned index;
+        };
+
+        /// Binary search address_map::ranges
+        unsigned search(uint64_t address) const;
+
+        /// Rebuild address_map::table after a range was added, or leave it
+        /// empty if the ranges do not allow one
+        void build_table();
+
+        /// The parts of every range given to add() which no earlier range
+        /// covers, sorted by first address
+        std::vector<range> ranges;
+
+        /// Entry i holds the index of the range containing the addresses
+        /// from table_base + (i << table_shift) for 1 << table_shift
+        /// bytes, or NONE.  Empty if find() has to search.
+        std::vector<unsigned> table;
+
+        /// First address covered by address_map::table
+        uint64_t table_base;
+
+        /// log2 of the number of addresses covered by each entry of
+        /// address_map::table
+        unsigned table_shift;
+
+};
+
+#endif // header guard
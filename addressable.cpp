@@ -13,7 +13,12 @@
 #include "addressable.h"
 
 // nothing to do here really
-// addressable's only member function is declared inline in addressable.h
+// most of addressable's member functions are declared inline in addressable.h
 
 
 addressable::addressable() {}
+
+void addressable::functional_access(component* source, uint64_t addr, bool write)
+{
+    // Default behavior is to do nothing
+}
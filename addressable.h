@@ -37,6 +37,21 @@ class addressable : public component
             return addr >= this->first_address && addr <= this->last_address;
         }
         
+        /// Functional (untimed) version of a read or write, used to keep
+        /// address mappings and row buffers warm while
+        /// system_driver::simulate_sampled fast-forwards between detailed
+        /// windows.  No packets are created.  The default behavior is to
+        /// do nothing.
+        virtual void functional_access
+        (
+            /// [in] The component which issued the access
+            component* source,
+            /// [in] Address within this addressable
+            uint64_t addr,
+            /// [in] true for a write, false for a read
+            bool write
+        );
+        
         virtual inline uint64_t get_first_address() const
         {
             return this->first_address;
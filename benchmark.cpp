@@ -0,0 +1,268 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              benchmark.cpp \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+// Simulator throughput benchmark.  Runs the bundled traces through the
+// 1, 2 and 4 CPU reference systems (see topology.h) and prints one line
+// per workload of space separated key=value pairs:
+//
+//     workload=<name> cpus=<n> load_s=<trace parsing time>
+//     wall_s=<simulation time> sim_cycles=<simulated cycles>
+//     cycles_per_s=<...> packets=<packets destroyed> packets_per_s=<...>
+//     peak_rss_kb=<...>
+//
+// Usage:
+//     benchmark --list                  names of all workloads
+//     benchmark <workload>              run one workload
+//     benchmark --all                   run every workload, each in its
+//                                       own process so peak_rss_kb is
+//                                       per workload
+//     benchmark --compare <baseline> <results> [tolerance %]
+//                                       compare two outputs of --all.
+//                                       Returns 1 if any workload's
+//                                       cycles_per_s dropped by more than
+//                                       tolerance (default 10%).
+//
+// Run from the directory containing trace_single.txt and traces/.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include "system_driver.h"
+#include "topology.h"
+#include "trace.h"
+
+using namespace std;
+
+struct workload
+{
+	const char* name;
+	unsigned num_cpus;
+	/// One trace per CPU
+	const char* traces[4];
+};
+
+static const workload workloads[] =
+{
+	{"single", 1, {"trace_single.txt"}},
+	{"w256_h256_r2", 1, {"trace_w256_h256_r2.txt"}},
+	{"convolution_dual", 2,
+		{
+			"traces/trace_convolution_dual_cpu1.txt",
+			"traces/trace_convolution_dual_cpu2.txt"
+		}},
+	// only one CPU's trace was bundled, so both CPUs read it (main_4cpu.cpp
+	// does the same)
+	{"merge_sort_dual", 2,
+		{
+			"traces/trace_merge_sort_dual_cpu0.txt",
+			"traces/trace_merge_sort_dual_cpu0.txt"
+		}},
+	{"convolution_quad", 4,
+		{
+			"traces/trace_convolution_quad_cpu1.txt",
+			"traces/trace_convolution_quad_cpu2.txt",
+			"traces/trace_convolution_quad_cpu3.txt",
+			"traces/trace_convolution_quad_cpu4.txt"
+		}},
+	{"merge_sort_quad", 4,
+		{
+			"traces/trace_merge_sort_quad_cpu0.txt",
+			"traces/trace_merge_sort_quad_cpu1.txt",
+			"traces/trace_merge_sort_quad_cpu2.txt",
+			"traces/trace_merge_sort_quad_cpu3.txt"
+		}}
+};
+static const unsigned num_workloads = sizeof(workloads) / sizeof(workloads[0]);
+
+// Peak resident set size of this process in kilobytes, 0 if unknown
+static long peak_rss_kb()
+{
+#ifndef _WIN32
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		return usage.ru_maxrss;
+#endif
+	return 0;
+}
+
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static int run_workload(const workload& w)
+{
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	vector<trace> parsed(w.num_cpus);
+	vector<const trace*> traces;
+	for (unsigned ix = 0; ix < w.num_cpus; ix++)
+	{
+		if (!parsed[ix].load(w.traces[ix]))
+			return -1;
+		traces.push_back(&parsed[ix]);
+	}
+	double load_s = seconds_since(start);
+
+	system_driver* motherboard = build_topology(default_topology(w.num_cpus), traces);
+	if (motherboard == NULL)
+		return -1;
+	motherboard->set_output(NULL);
+
+	start = chrono::steady_clock::now();
+	motherboard->simulate();
+	double wall_s = seconds_since(start);
+
+	// get_time() leaves out the UINT_MAX simulate() adds at quiescence
+	unsigned long sim_cycles = motherboard->get_time();
+	unsigned long packets = motherboard->get_packets_destroyed();
+	delete motherboard;
+
+	cout
+		<< fixed << setprecision(3)
+		<< "workload=" << w.name
+		<< " cpus=" << w.num_cpus
+		<< " load_s=" << load_s
+		<< " wall_s=" << wall_s
+		<< " sim_cycles=" << sim_cycles
+		<< setprecision(0)
+		<< " cycles_per_s=" << sim_cycles / wall_s
+		<< " packets=" << packets
+		<< " packets_per_s=" << packets / wall_s
+		<< " peak_rss_kb=" << peak_rss_kb()
+		<< endl;
+	return 0;
+
+}
+
+// Read the output of --all into results[workload][key]
+static bool read_results(const char* filename, map<string, map<string, string> >& results)
+{
+	ifstream in(filename);
+	if (!in.good())
+	{
+		cerr << "Error. Failed to open " << filename << " for reading" << endl;
+		return false;
+	}
+	string line;
+	while (getline(in, line))
+	{
+		map<string, string> fields;
+		istringstream iss(line);
+		string pair;
+		while (iss >> pair)
+		{
+			size_t eq = pair.find('=');
+			if (eq != string::npos)
+				fields[pair.substr(0, eq)] = pair.substr(eq + 1);
+		}
+		if (fields.count("workload"))
+			results[fields["workload"]] = fields;
+	}
+	return true;
+}
+
+static int compare(const char* baseline_file, const char* results_file, double tolerance)
+{
+
+	map<string, map<string, string> > baseline, results;
+	if (!read_results(baseline_file, baseline) || !read_results(results_file, results))
+		return -1;
+
+	int status = 0;
+	for (map<string, map<string, string> >::iterator it = results.begin(); it != results.end(); it++)
+	{
+		cout << "workload=" << it->first;
+		if (baseline.count(it->first) == 0)
+		{
+			cout << " status=new" << endl;
+			continue;
+		}
+		map<string, string>& old_fields = baseline[it->first];
+		map<string, string>& new_fields = it->second;
+
+		double old_rate = atof(old_fields["cycles_per_s"].c_str());
+		double new_rate = atof(new_fields["cycles_per_s"].c_str());
+		double change = old_rate > 0 ? 100.0 * (new_rate - old_rate) / old_rate : 0.0;
+		cout << fixed << setprecision(1) << " cycles_per_s_change=" << showpos << change << "%" << noshowpos;
+
+		// a simulator change which alters the simulated result is worth
+		// knowing about, but isn't a performance regression
+		if (old_fields["sim_cycles"] != new_fields["sim_cycles"])
+			cout << " sim_cycles_was=" << old_fields["sim_cycles"];
+
+		if (change < -tolerance)
+		{
+			cout << " status=regression" << endl;
+			status = 1;
+		}
+		else
+		{
+			cout << " status=ok" << endl;
+		}
+	}
+	return status;
+
+}
+
+int main(int argc, char** argv)
+{
+
+	if (argc == 2 && strcmp(argv[1], "--list") == 0)
+	{
+		for (unsigned ix = 0; ix < num_workloads; ix++)
+			cout << workloads[ix].name << endl;
+		return 0;
+	}
+
+	if (argc == 2 && strcmp(argv[1], "--all") == 0)
+	{
+		int status = 0;
+		for (unsigned ix = 0; ix < num_workloads; ix++)
+		{
+			cout.flush();
+			string command = string("\"") + argv[0] + "\" " + workloads[ix].name;
+			if (system(command.c_str()) != 0)
+				status = 1;
+		}
+		return status;
+	}
+
+	if ((argc == 4 || argc == 5) && strcmp(argv[1], "--compare") == 0)
+		return compare(argv[2], argv[3], argc == 5 ? atof(argv[4]) : 10.0);
+
+	if (argc == 2)
+	{
+		for (unsigned ix = 0; ix < num_workloads; ix++)
+		{
+			if (strcmp(argv[1], workloads[ix].name) == 0)
+				return run_workload(workloads[ix]);
+		}
+	}
+
+	cerr
+		<< "Usage: " << argv[0] << " --list | --all | <workload> | "
+		<< "--compare <baseline> <results> [tolerance %]"
+		<< endl;
+	return -1;
+
+}
@@ -0,0 +1,210 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              cache.cpp \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#include <iomanip>
+#include "cache.h"
+#include "checkpoint.h"
+#include "debug.h"
+
+cache::cache
+(
+    unsigned size_bytes_,
+    unsigned ways_,
+    unsigned line_bytes_,
+    unsigned hit_latency_,
+    replacement_policy policy_
+){
+
+    check(ways_ > 0 && ways_ <= 64, "A cache needs between 1 and 64 ways");
+    check(line_bytes_ > 0 && (line_bytes_ & (line_bytes_ - 1)) == 0, "Cache lines must be a power of 2 bytes");
+    check(policy_ != PLRU || (ways_ & (ways_ - 1)) == 0, "PLRU needs a power of 2 ways");
+    this->ways = ways_;
+    this->line_bytes = line_bytes_;
+    this->hit_latency = hit_latency_;
+    this->policy = policy_;
+    this->hits = 0;
+    this->misses = 0;
+    this->writebacks = 0;
+    this->clock = 0;
+
+    this->line_shift = 0;
+    while ((1u << this->line_shift) < line_bytes_)
+        this->line_shift++;
+    this->num_sets = size_bytes_ / (line_bytes_ * ways_);
+    check
+    (
+        this->num_sets > 0 && (this->num_sets & (this->num_sets - 1)) == 0,
+        "A cache needs a power of 2 sets"
+    );
+    if (this->num_sets == 0)
+        this->num_sets = 1;
+
+    line empty;
+    empty.address = 0;
+    empty.last_used = 0;
+    empty.valid = false;
+    empty.dirty = false;
+    this->lines.assign(this->num_sets * this->ways, empty);
+    this->plru_bits.assign(this->num_sets, 0);
+
+}
+
+bool cache::access(uint64_t address, bool write, bool& writeback, uint64_t& victim)
+{
+
+    writeback = false;
+    uint64_t line_addr = this->line_address(address);
+    unsigned set = (unsigned)(line_addr >> this->line_shift) & (this->num_sets - 1);
+    line* first = &this->lines[set * this->ways];
+
+    for (unsigned way = 0; way < this->ways; way++)
+    {
+        if (first[way].valid && first[way].address == line_addr)
+        {
+            first[way].dirty |= write;
+            this->touch(set, way);
+            this->hits++;
+            return true;
+        }
+    }
+
+    this->misses++;
+    unsigned way = this->find_victim(set);
+    if (first[way].valid && first[way].dirty)
+    {
+        writeback = true;
+        victim = first[way].address;
+        this->writebacks++;
+    }
+    first[way].address = line_addr;
+    first[way].valid = true;
+    first[way].dirty = write;
+    this->touch(set, way);
+    return false;
+
+}
+
+unsigned cache::find_victim(unsigned set) const
+{
+
+    const line* first = &this->lines[set * this->ways];
+    for (unsigned way = 0; way < this->ways; way++)
+    {
+        if (!first[way].valid)
+            return way;
+    }
+
+    if (this->policy == PLRU)
+    {
+        // follow the bits down from the root
+        uint64_t bits = this->plru_bits[set];
+        unsigned node = 1;
+        while (node < this->ways)
+            node = 2 * node + (unsigned)((bits >> node) & 1);
+        return node - this->ways;
+    }
+
+    unsigned oldest = 0;
+    for (unsigned way = 1; way < this->ways; way++)
+    {
+        if (first[way].last_used < first[oldest].last_used)
+            oldest = way;
+    }
+    return oldest;
+
+}
+
+void cache::touch(unsigned set, unsigned way)
+{
+
+    this->lines[set * this->ways + way].last_used = ++this->clock;
+    if (this->policy != PLRU)
+        return;
+
+    // point every node on the path away from way
+    uint64_t& bits = this->plru_bits[set];
+    unsigned node = way + this->ways;
+    while (node > 1)
+    {
+        unsigned parent = node / 2;
+        if (node & 1)
+            bits &= ~((uint64_t)1 << parent);
+        else
+            bits |= (uint64_t)1 << parent;
+        node = parent;
+    }
+
+}
+
+void cache::print(const std::string& name, std::ostream* file) const
+{
+    unsigned long accesses = this->hits + this->misses;
+    double hit_rate = accesses == 0
+        ? 0.0
+        : 100.0 * this->hits / accesses;
+    std::ios::fmtflags flags = file->flags();
+    std::streamsize precision = file->precision();
+    *file
+        << std::left
+        << std::setw(30) << name.substr(0, 29)
+        << std::right
+        << std::setw(12) << this->hits
+        << std::setw(12) << this->misses
+        << std::setw(11) << std::fixed << std::setprecision(1) << hit_rate << '%'
+        << std::setw(12) << this->writebacks
+        << std::endl;
+    file->flags(flags);
+    file->precision(precision);
+}
+
+void cache::save(std::ostream& out) const
+{
+    checkpoint_write(out, (uint32_t)this->lines.size());
+    checkpoint_write(out, this->clock);
+    for (unsigned ix = 0; ix < this->lines.size(); ix++)
+    {
+        const line& l = this->lines[ix];
+        checkpoint_write(out, l.address);
+        checkpoint_write(out, l.last_used);
+        checkpoint_write(out, l.valid);
+        checkpoint_write(out, l.dirty);
+    }
+    for (unsigned ix = 0; ix < this->plru_bits.size(); ix++)
+        checkpoint_write(out, this->plru_bits[ix]);
+}
+
+bool cache::restore(std::istream& in)
+{
+    uint32_t num_lines;
+    if (!checkpoint_read(in, num_lines) || num_lines != this->lines.size())
+        return false;
+    if (!checkpoint_read(in, this->clock))
+        return false;
+    for (unsigned ix = 0; ix < this->lines.size(); ix++)
+    {
+        line& l = this->lines[ix];
+        if
+        (
+            !checkpoint_read(in, l.address) ||
+            !checkpoint_read(in, l.last_used) ||
+            !checkpoint_read(in, l.valid) ||
+            !checkpoint_read(in, l.dirty)
+        )
+            return false;
+    }
+    for (unsigned ix = 0; ix < this->plru_bits.size(); ix++)
+    {
+        if (!checkpoint_read(in, this->plru_bits[ix]))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,159 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              cache.h \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#ifndef __HEADER_GUARD_CACHE__
+#define __HEADER_GUARD_CACHE__
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// \class cache
+/// One level of a \ref cpu "CPU's" private cache hierarchy, see
+/// cpu::add_cache.  The cache is set associative, write back and write
+/// allocate, and only tracks which lines it holds: it is not a
+/// \ref component and never sees packets.  The CPU looks every access up
+/// level by level and only sends the misses, and the dirty lines they
+/// evict, into the network.
+///
+/// A line is allocated as soon as it misses rather than when its data
+/// arrives, so a second access to a line which is still being fetched
+/// counts as a hit.
+class cache
+{
+
+    public:
+
+        /// How the line to evict from a full set is chosen
+        enum replacement_policy : uint8_t
+        {
+            /// Least recently used
+            LRU,
+            /// Tree pseudo-LRU, one bit per node of a binary tree over
+            /// the ways
+            PLRU
+        };
+
+        cache
+        (
+            /// [in] Capacity in bytes
+            unsigned size_bytes_,
+            /// [in] See cache::ways
+            unsigned ways_,
+            /// [in] See cache::line_bytes
+            unsigned line_bytes_ = 64,
+            /// [in] See cache::hit_latency
+            unsigned hit_latency_ = 4,
+            /// [in] See cache::policy
+            replacement_policy policy_ = LRU
+        );
+
+        /// Look up the line holding address and mark it most recently
+        /// used, allocating it if it is not there.  A write leaves the
+        /// line dirty.
+        /// \return true on a hit
+        bool access
+        (
+            /// [in] Any address within the line
+            uint64_t address,
+            /// [in] true for a write
+            bool write,
+            /// [out] Set if allocating the line evicted a dirty line,
+            /// which must be written to the next level
+            bool& writeback,
+            /// [out] Address of the evicted line if writeback was set
+            uint64_t& victim
+        );
+
+        /// \return address rounded down to the start of its line
+        inline uint64_t line_address(uint64_t address) const
+        {
+            return address & ~(uint64_t)(this->line_bytes - 1);
+        }
+
+        /// Print the hit and miss counters on one line
+        void print
+        (
+            /// [in] What to call this cache, for example "CPU0 L1"
+            const std::string& name,
+            /// [out] Stream to print to
+            std::ostream* file = &(std::cout)
+        ) const;
+
+        /// Write which lines are held, and in what order they were used,
+        /// to a checkpoint.  See component::save
+        void save(std::ostream& out) const;
+
+        /// Read what save() wrote
+        /// \return false if the checkpoint was made with a cache of a
+        /// different shape
+        bool restore(std::istream& in);
+
+        /// Ways in each set
+        unsigned ways;
+
+        /// Bytes in each line, a power of 2.  Misses and write-backs move
+        /// whole lines.
+        unsigned line_bytes;
+
+        /// Ticks a lookup in this level takes, whether it hits or not
+        unsigned hit_latency;
+
+        /// See replacement_policy
+        replacement_policy policy;
+
+        /// Counters printed by print().  Not saved in checkpoints.
+        unsigned long hits;
+        unsigned long misses;
+        unsigned long writebacks;
+
+    protected:
+
+        /// One way of one set
+        struct line
+        {
+            /// Line address (see line_address()) of the data held
+            uint64_t address;
+            /// Value of cache::clock when the line was last used, for LRU
+            uint64_t last_used;
+            bool valid;
+            bool dirty;
+        };
+
+        /// \return The way to evict from set, an invalid one if there is
+        /// one
+        unsigned find_victim(unsigned set) const;
+
+        /// Mark way the most recently used of set
+        void touch(unsigned set, unsigned way);
+
+        /// Number of sets, a power of 2
+        unsigned num_sets;
+
+        /// log2 of cache::line_bytes
+        unsigned line_shift;
+
+        /// ways lines for each set, one set after another
+        std::vector<line> lines;
+
+        /// Tree bits of each set for PLRU.  Node n has children 2n and
+        /// 2n+1 and the root is node 1, so bit n set means the victim is
+        /// in the subtree of 2n+1.
+        std::vector<uint64_t> plru_bits;
+
+        /// Counts accesses, the timestamp used for LRU
+        uint64_t clock;
+
+};
+
+#endif // header guard
@@ -0,0 +1,62 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              checkpoint.h \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#ifndef __HEADER_GUARD_CHECKPOINT__
+#define __HEADER_GUARD_CHECKPOINT__
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Helpers for reading and writing the binary checkpoints made by
+// system_driver::save_checkpoint.  Values are stored in host byte order,
+// so checkpoints are only portable between machines of the same
+// architecture.
+
+/// Write a plain-old-data value to a checkpoint
+template <typename T>
+inline void checkpoint_write(std::ostream& out, const T& value)
+{
+    out.write((const char*)&value, sizeof(T));
+}
+
+/// Read a plain-old-data value from a checkpoint
+/// \return false if the checkpoint ended early
+template <typename T>
+inline bool checkpoint_read(std::istream& in, T& value)
+{
+    in.read((char*)&value, sizeof(T));
+    return in.good();
+}
+
+/// Write a length-prefixed string to a checkpoint
+inline void checkpoint_write(std::ostream& out, const std::string& value)
+{
+    uint32_t length = value.size();
+    checkpoint_write(out, length);
+    out.write(value.data(), length);
+}
+
+/// Read a length-prefixed string from a checkpoint
+/// \return false if the checkpoint ended early
+inline bool checkpoint_read(std::istream& in, std::string& value)
+{
+    uint32_t length;
+    if (!checkpoint_read(in, length))
+        return false;
+    value.resize(length);
+    if (length > 0)
+        in.read(&value[0], length);
+    return in.good();
+}
+
+#endif // header guard
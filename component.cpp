@@ -10,14 +10,88 @@
 ///							Windows 7 \n
 /// Target architecture:    x86_64 */
 
+#include <algorithm>
 #include <unordered_map>
 #include <iostream>
+#include <sstream>
+#include "checkpoint.h"
 #include "component.h"
 #include "debug.h"
+#include "hmc_link.h"
 #include "packet.h"
+#include "system_driver.h"
+#if defined(__AVX2__) && ULONG_MAX > 0xFFFFFFFFUL
+    #include <immintrin.h>
+    #define COMPONENT_AVX2 1
+#else
+    #define COMPONENT_AVX2 0
+#endif
 
 using namespace std;
 
+// Scans over component::resident_wake.  Build with make AVX2=1 (or
+// -march=native) to check four wake times at once.  Wake times never come
+// near 2^63, so AVX2's signed 64 bit compare is safe.
+
+// \return the index of the first of times[from .. num_times - 1] which is
+// <= now, or num_times if there is none
+static unsigned find_ready
+(
+    const unsigned long* times,
+    unsigned from,
+    unsigned num_times,
+    unsigned long now
+){
+    unsigned ix = from;
+#if COMPONENT_AVX2 == 1
+    __m256i limit = _mm256_set1_epi64x((long long)now);
+    for (; ix + 4 <= num_times; ix += 4)
+    {
+        __m256i t = _mm256_loadu_si256((const __m256i*)(times + ix));
+        int late = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(t, limit)));
+        if (late != 0xF)
+            break; // one of these four is ready, the loop below finds it
+    }
+#endif
+    for (; ix < num_times; ix++)
+    {
+        if (times[ix] <= now)
+            return ix;
+    }
+    return num_times;
+}
+
+// \return the lowest of times[0 .. num_times - 1], ULONG_MAX if num_times is 0
+static unsigned long find_min(const unsigned long* times, unsigned num_times)
+{
+    unsigned long min_time = ULONG_MAX;
+    unsigned ix = 0;
+#if COMPONENT_AVX2 == 1
+    if (num_times >= 4)
+    {
+        __m256i m = _mm256_loadu_si256((const __m256i*)times);
+        for (ix = 4; ix + 4 <= num_times; ix += 4)
+        {
+            __m256i t = _mm256_loadu_si256((const __m256i*)(times + ix));
+            m = _mm256_blendv_epi8(m, t, _mm256_cmpgt_epi64(m, t));
+        }
+        unsigned long lanes[4];
+        _mm256_storeu_si256((__m256i*)lanes, m);
+        for (unsigned lane = 0; lane < 4; lane++)
+        {
+            if (lanes[lane] < min_time)
+                min_time = lanes[lane];
+        }
+    }
+#endif
+    for (; ix < num_times; ix++)
+    {
+        if (times[ix] < min_time)
+            min_time = times[ix];
+    }
+    return min_time;
+}
+
 component::component
 (
     const std::string& name_,
@@ -32,7 +106,16 @@ component::component
     this->max_resident_packets = max_resident_packets_;
     this->routing_latency = routing_latency_;
     this->retirement_latency = retirement_latency_;
-    this->cooldown = 0;
+    this->ready_at = 0;
+    this->driver = NULL;
+    this->id = 0;
+    this->next_wake = ULONG_MAX;
+    this->generate_at = 0;
+    this->generate_deadline = ULONG_MAX;
+    this->packets_destroyed = 0;
+#if PROFILE == 1
+    this->profile_data = profile_counters();
+#endif
 }
 
 component::~component()
@@ -41,6 +124,8 @@ component::~component()
     for (unsigned ix = 0; ix < num_resident_packets; ix++)
         delete this->resident_packets[ix];
         // no need to NULL-out, the vector will be destroyed soon
+    for (unsigned ix = 0; ix < this->links.size(); ix++)
+        delete this->links[ix];
 }
 
 void component::add_route
@@ -53,77 +138,54 @@ void component::add_route
     this->routing_table.insert({final_destination, immediate_destination});
 }
 
-unsigned component::advance_cooldowns(unsigned time)
-{
-    
-	this->cycle += time;
-
-    // advance the cooldown for this component
-    if (time < this->cooldown)
-        this->cooldown -= time;
-    else
-        this->cooldown = 0;
-    
-    // advance the cooldowns for all resident packets
-    // do not include component cooldown in minima calculation, since
-    // we don't want to get stuck because "a components are ready"
-    unsigned min_cooldown = UINT_MAX;
-    unsigned num_resident_packets = this->resident_packets.size();
-    for (unsigned ix = 0; ix < num_resident_packets; ix++)
-    {
-        
-        packet* p = this->resident_packets[ix];
-        unsigned c = p->cooldown;
-        
-        if (time < c)
-            c -= time;
-        else
-            c = 0;
-        
-        p->cooldown = c;
-        
-        if (c < min_cooldown)
-            min_cooldown = c;
-        
-    }
-    
-    return min_cooldown;
-    
+void component::add_link
+(
+    component* neighbor,
+    unsigned lanes,
+    unsigned lane_rate,
+    unsigned max_tokens
+){
+    check(neighbor != NULL && neighbor != this, "A link must lead to another component");
+    check(this->find_link(neighbor) == NULL, "There is already a link to this neighbor");
+    this->links.push_back(new hmc_link(this, neighbor, lanes, lane_rate, max_tokens));
 }
 
 unsigned component::wake_packets()
 {
     
+    unsigned long now = this->get_time();
+    
     // Iterate through all resident packets, looking for ones that are
     // cooled down
     unsigned min_cooldown = UINT_MAX;
     // must check size() every time in loop in case a packet
     // migrates away, dies, or is generated
-    for (unsigned ix = 0; ix < this->resident_packets.size(); ix++)
-    {
-        
-        packet* p = this->resident_packets[ix];
+    for
+    (
+        unsigned ix = find_ready(this->resident_wake.data(), 0, this->resident_wake.size(), now);
+        ix < this->resident_packets.size();
+        ix = find_ready(this->resident_wake.data(), ix + 1, this->resident_wake.size(), now)
+    ){
         
         // we found a packet
-        if (p->cooldown == 0)
-        {
-            unsigned c;
-            
-			if (p->final_destination == this) {
-				// the packet has reached its final destiny
-				c = this->retire(ix);
-			}
-			else {
-				// the packet needs to be routed somewhere else
-				c = this->port_out(ix);
-			}
-            // only need to account for cooldowns which this function changed
-            // in minima calculation
-            if (c < min_cooldown)
-                min_cooldown = c;
+        unsigned c;
+        if (this->resident_packets[ix]->final_destination == this->id) {
+            // the packet has reached its final destiny
+            profile(this->profile_data, PROFILE_RETIRE);
+            c = this->retire(ix);
+        }
+        else {
+            // the packet needs to be routed somewhere else
+            c = this->port_out(ix);
         }
+        // only need to account for cooldowns which this function changed
+        // in minima calculation.  A blocked packet has no cooldown, it
+        // waits for release_waiting()
+        if (c < min_cooldown && c != BLOCKED)
+            min_cooldown = c;
         
     }
+    this->refresh_wake();
     
     return min_cooldown;
     
@@ -141,30 +203,29 @@ unsigned component::port_in(unsigned packet_index, component* source)
     check(source != NULL, "souce component cannot be NULL");
     
     // make sure the component has not accepted another packet too recently
-    if (this->cooldown > 0)
-        return this->cooldown;
+    unsigned long now = this->get_time();
+    if (this->ready_at > now)
+        return (unsigned)(this->ready_at - now);
     
     // make sure this component is not at its maximum packet capacity
 	if (this->resident_packets.size() >= this->max_resident_packets) {
-		// source->resident_packets[packet_index]->cooldown = 1;
-		return 1; //  this->min_packet_cooldown();
+		return this->block(source);
 	}
     
     // this component is capable of accepting new packets - move it
-    packet* p = this->resident_packets
-    [
-        this->move_packet(packet_index, source, this)
-    ];
+    unsigned ix = this->move_packet(packet_index, source, this);
+    packet* p = this->resident_packets[ix];
     
     // since this component just accepted a packet, the component
     // itself needs to cool down before accepting another
-    this->cooldown = this->initiation_interval;
+    this->ready_at = now + this->initiation_interval;
     
-    // calculate new packet cooldown
-    if (p->final_destination == this)
-        p->cooldown = this->retirement_latency;
+    // calculate new packet wake time
+    if (p->final_destination == this->id)
+        this->resident_wake[ix] = now + this->retirement_latency;
     else
-        p->cooldown = this->routing_latency;
+        this->resident_wake[ix] = now + this->routing_latency;
+    this->schedule_wake(this->resident_wake[ix]);
     
     // the packet has left source, therefore its new cooldown on source
     // is eternity
@@ -184,28 +245,26 @@ unsigned component::port_out(unsigned packet_index)
     // Use routing table to calculate the next waypoint in this packet's
     // path to its final destination
     packet* p = this->resident_packets[packet_index];
-    component* immediate_destination = this->routing_table[p->final_destination];
-	if (immediate_destination == NULL) {
-		cout << "Error: No Immediate Destination for Packet " << p->name << " At Component: " << this->name << endl;
-		cout << "Press Enter to Exit" << endl;
-		exit((int) getchar());
-	}
+    component* immediate_destination = this->next_hop[p->final_destination];
+    // system_driver::check_routes has made sure the route exists
+    check
+    (
+        immediate_destination != NULL,
+        "No Immediate Destination for Packet " << this->packet_name(p) << " At Component: " << this->name
+    );
     
-    unsigned new_cooldown = immediate_destination->port_in(packet_index, this);
-    // only assign a new cooldown if the migration failed
-    if (new_cooldown != UINT_MAX)
-        p->cooldown = new_cooldown;
+    unsigned new_cooldown = this->send_packet(packet_index, immediate_destination);
     
 if (DEBUG) {
     if (new_cooldown == UINT_MAX)
     {
     	cout
     	    << "Moved \""
-    	    << p->name
+    	    << this->packet_name(p)
     	    << "\" from \""
     	    << this->name
     	    << "\" to \""
-    	    << this->routing_table[p->final_destination]->name
+    	    << immediate_destination->name
     	    << '\"'
     	    << endl;
     }
@@ -221,7 +280,7 @@ unsigned component::retire(unsigned packet_index)
 	if (DEBUG) {
 		cout
 			<< '\"'
-			<< resident_packets[packet_index]->name
+			<< this->packet_name(this->resident_packets[packet_index])
 			<< "\" has retired at \""
 			<< this->name
 			<< '\"'
@@ -240,11 +299,34 @@ unsigned component::generate()
     return UINT_MAX;
 }
 
+unsigned long component::fast_forward(unsigned long num_records)
+{
+    // Default behavior is to do nothing
+    return 0;
+}
+
+unsigned long component::get_records_read() const
+{
+    return 0;
+}
+
+void component::print_stats(std::ostream* file) const
+{
+    // Default behavior is to do nothing
+}
+
+void component::required_routes(std::vector<std::pair<const component*, const component*> >& routes) const
+{
+    // Default behavior is to need no routes
+}
+
 void component::print(std::ostream* file) const
 {
     
     // print component name
-    *file << '\"' << this->name << "\" cooldown = " << this->cooldown << endl;
+    unsigned long now = this->get_time();
+    unsigned long cooldown = this->ready_at > now ? this->ready_at - now : 0;
+    *file << '\"' << this->name << "\" cooldown = " << cooldown << endl;
     
     // print all resident packet's names
     unsigned num_resident_packets = this->resident_packets.size();
@@ -255,20 +337,219 @@ void component::print(std::ostream* file) const
         for (unsigned ix = 0; ix < num_resident_packets; ix++)
         {
             const packet* p = this->resident_packets[ix];
+            const component* source = this->lookup(p->original_source);
+            const component* destination = this->lookup(p->final_destination);
             *file
                 << "\t\""
-                << p->name
+                << this->packet_name(p)
                 << "\" {\""
-                << p->original_source->name
+                << (source == NULL ? "?" : source->name)
                 << "\" --> \""
-                << p->final_destination->name
+                << (destination == NULL ? "?" : destination->name)
                 << "\"} cooldown = "
-                << p->cooldown
+                << (this->resident_wake[ix] > now ? this->resident_wake[ix] - now : 0)
                 << endl;
         }
     }
 }
 
+void component::save(std::ostream& out)
+{
+    
+    checkpoint_write(out, this->name);
+    checkpoint_write(out, this->ready_at);
+    checkpoint_write(out, this->generate_at);
+    checkpoint_write(out, this->generate_deadline);
+    
+    uint32_t num_links = this->links.size();
+    checkpoint_write(out, num_links);
+    for (unsigned ix = 0; ix < num_links; ix++)
+    {
+        checkpoint_write(out, this->links[ix]->tokens);
+        checkpoint_write(out, this->links[ix]->free_at);
+    }
+    
+    uint32_t num_resident_packets = this->resident_packets.size();
+    checkpoint_write(out, num_resident_packets);
+    for (unsigned ix = 0; ix < num_resident_packets; ix++)
+    {
+        const packet* p = this->resident_packets[ix];
+        checkpoint_write(out, p->original_source);
+        checkpoint_write(out, p->final_destination);
+        checkpoint_write(out, p->swap_destination);
+        checkpoint_write(out, p->swap_tag);
+        checkpoint_write(out, p->type);
+        checkpoint_write(out, p->address);
+        checkpoint_write(out, p->bytes_accessed);
+        checkpoint_write(out, this->resident_wake[ix]);
+        checkpoint_write(out, p->issued_at);
+        
+        // a credit is saved as the index of the component at the sending
+        // end of its link
+        const link_credit& credit = this->resident_credit[ix];
+        uint16_t link_source = credit.link == NULL
+            ? packet::NO_COMPONENT
+            : (uint16_t)credit.link->source->get_id();
+        checkpoint_write(out, link_source);
+        checkpoint_write(out, credit.flits);
+    }
+    
+}
+
+bool component::restore(std::istream& in)
+{
+    
+    std::string saved_name;
+    if (!checkpoint_read(in, saved_name) || saved_name != this->name)
+    {
+        cerr
+            << "Error. Checkpoint has component \""
+            << saved_name
+            << "\" where \""
+            << this->name
+            << "\" was expected"
+            << endl;
+        return false;
+    }
+    
+    // throw away whatever was in flight before
+    unsigned num_resident_packets = this->resident_packets.size();
+    for (unsigned ix = 0; ix < num_resident_packets; ix++)
+        delete this->resident_packets[ix];
+    this->resident_packets.clear();
+    this->resident_wake.clear();
+    this->resident_credit.clear();
+    this->waiting.clear();
+    
+    uint32_t num_saved_links;
+    if
+    (
+        !checkpoint_read(in, this->ready_at) ||
+        !checkpoint_read(in, this->generate_at) ||
+        !checkpoint_read(in, this->generate_deadline) ||
+        !checkpoint_read(in, num_saved_links)
+    )
+        return false;
+    
+    if (num_saved_links != this->links.size())
+    {
+        cerr << "Error. Checkpoint has a different number of links from \"" << this->name << '\"' << endl;
+        return false;
+    }
+    for (unsigned ix = 0; ix < num_saved_links; ix++)
+    {
+        if
+        (
+            !checkpoint_read(in, this->links[ix]->tokens) ||
+            !checkpoint_read(in, this->links[ix]->free_at)
+        )
+            return false;
+    }
+    
+    uint32_t num_saved_packets;
+    if (!checkpoint_read(in, num_saved_packets))
+        return false;
+    
+    this->resident_packets.reserve(num_saved_packets);
+    this->resident_wake.reserve(num_saved_packets);
+    this->resident_credit.reserve(num_saved_packets);
+    for (unsigned ix = 0; ix < num_saved_packets; ix++)
+    {
+        uint16_t source_id;
+        uint16_t destination_id;
+        uint16_t swap_id;
+        unsigned swap_tag;
+        packetType type;
+        uint64_t address;
+        unsigned bytes_accessed;
+        unsigned long wake_at;
+        unsigned long issued_at;
+        uint16_t link_source;
+        unsigned link_flits;
+        if
+        (
+            !checkpoint_read(in, source_id) ||
+            !checkpoint_read(in, destination_id) ||
+            !checkpoint_read(in, swap_id) ||
+            !checkpoint_read(in, swap_tag) ||
+            !checkpoint_read(in, type) ||
+            !checkpoint_read(in, address) ||
+            !checkpoint_read(in, bytes_accessed) ||
+            !checkpoint_read(in, wake_at) ||
+            !checkpoint_read(in, issued_at) ||
+            !checkpoint_read(in, link_source) ||
+            !checkpoint_read(in, link_flits)
+        )
+            return false;
+        
+        hmc_link* l = NULL;
+        if (link_source != packet::NO_COMPONENT)
+        {
+            const component* sender = this->lookup(link_source);
+            l = sender == NULL ? NULL : sender->find_link(this);
+            if (l == NULL)
+            {
+                cerr << "Error. Checkpoint packet arrived over a link which does not exist" << endl;
+                return false;
+            }
+        }
+        
+        if
+        (
+            this->lookup(source_id) == NULL ||
+            this->lookup(destination_id) == NULL ||
+            (swap_id != packet::NO_COMPONENT && this->lookup(swap_id) == NULL)
+        )
+        {
+            cerr << "Error. Checkpoint packet refers to a component which does not exist" << endl;
+            return false;
+        }
+        
+        // wait lists are not saved, so blocked packets retry straight away
+        // and block again if they still do not fit
+        if (wake_at == NEVER)
+            wake_at = this->get_time();
+        
+        this->add_packet
+        (
+            new packet
+            (
+                source_id,
+                destination_id,
+                swap_id,
+                swap_tag,
+                type,
+                address,
+                bytes_accessed,
+                issued_at
+            ),
+            wake_at
+        );
+        this->resident_credit.back() = {l, link_flits};
+    }
+    
+    this->refresh_wake();
+    return true;
+    
+}
+
+hmc_link* component::find_link(const component* neighbor) const
+{
+    for (unsigned ix = 0; ix < this->links.size(); ix++)
+    {
+        if (this->links[ix]->destination == neighbor)
+            return this->links[ix];
+    }
+    return NULL;
+}
+
+component* component::lookup(unsigned id) const
+{
+    if (this->driver == NULL)
+        return NULL;
+    return this->driver->get_component(id);
+}
+
 unsigned component::move_packet
 (
     unsigned packet_index,
@@ -279,45 +560,228 @@ unsigned component::move_packet
     // note that that packet is not re-allocated,
     // the pointer just changes hands
     packet* p = source->resident_packets[packet_index];
+    unsigned long wake_at = source->resident_wake[packet_index];
+    
+    // the packet leaves source's input buffer
+    const link_credit& credit = source->resident_credit[packet_index];
+    if (credit.link != NULL)
+        credit.link->return_tokens(credit.flits);
     
     // remove packet from source
     // move the last packet from source into the vacated sport
     // shrink source packet vector by 1
     unsigned last_source_ix = source->resident_packets.size() - 1;
     source->resident_packets[packet_index] = source->resident_packets[last_source_ix];
+    source->resident_wake[packet_index] = source->resident_wake[last_source_ix];
+    source->resident_credit[packet_index] = source->resident_credit[last_source_ix];
     source->resident_packets.resize(last_source_ix);
+    source->resident_wake.resize(last_source_ix);
+    source->resident_credit.resize(last_source_ix);
     
-    // add the packet to destination vector
+    // add the packet to destination vector.  send_packet() fills in the
+    // credit if it came over a link
     destination->resident_packets.push_back(p);
+    destination->resident_wake.push_back(wake_at);
+    destination->resident_credit.push_back({NULL, 0});
+    
+    // both ends may have something new to generate now, and anything
+    // source turned away may fit
+    unsigned long now = this->get_time();
+    source->request_generate(now);
+    destination->request_generate(now);
+    source->release_waiting();
     
     return destination->resident_packets.size() - 1;
     
 }
 
+unsigned component::send_packet(unsigned packet_index, component* destination)
+{
+    
+    unsigned long now = this->get_time();
+    packet* p = this->resident_packets[packet_index];
+    hmc_link* l = this->link_to.empty() ? NULL : this->link_to[destination->id];
+    unsigned num_flits = 0;
+    unsigned new_cooldown = 0;
+    if (l != NULL)
+    {
+        num_flits = hmc_link::flits(p);
+        new_cooldown = l->check_send(num_flits, now);
+        // tokens come back when a packet leaves destination, which is
+        // also when destination wakes the components waiting on it
+        if (new_cooldown == UINT_MAX)
+            new_cooldown = destination->block(this);
+    }
+    
+    if (new_cooldown == 0)
+    {
+        profile(destination->profile_data, PROFILE_PORT_IN);
+        new_cooldown = destination->port_in(packet_index, this);
+#if PROFILE == 1
+        if (new_cooldown != UINT_MAX)
+            destination->profile_data.port_in_rejected++;
+#endif
+        if (new_cooldown == UINT_MAX && l != NULL)
+        {
+            // the packet arrives once its last FLIT is across.  A packet
+            // destination consumed on the spot hands its tokens straight back
+            unsigned ticks = l->send(num_flits, now);
+            if (!destination->resident_packets.empty() && destination->resident_packets.back() == p)
+            {
+                destination->resident_wake.back() += ticks;
+                destination->resident_credit.back() = {l, num_flits};
+            }
+            else
+            {
+                l->return_tokens(num_flits);
+            }
+        }
+    }
+    
+    // only assign a new wake time if the migration failed
+    if (new_cooldown == BLOCKED)
+        this->resident_wake[packet_index] = NEVER;
+    else if (new_cooldown != UINT_MAX)
+        this->resident_wake[packet_index] = this->get_time() + new_cooldown;
+    return new_cooldown;
+    
+}
+
+unsigned component::block(component* source)
+{
+    if (std::find(this->waiting.begin(), this->waiting.end(), source) == this->waiting.end())
+        this->waiting.push_back(source);
+    return BLOCKED;
+}
+
+void component::release_waiting()
+{
+    unsigned num_waiting = this->waiting.size();
+    for (unsigned w = 0; w < num_waiting; w++)
+    {
+        component* c = this->waiting[w];
+        unsigned long retry_at = this->driver == NULL
+            ? 0
+            : this->driver->retry_time(c);
+        unsigned num_resident_packets = c->resident_wake.size();
+        for (unsigned ix = 0; ix < num_resident_packets; ix++)
+        {
+            if (c->resident_wake[ix] == NEVER)
+                c->resident_wake[ix] = retry_at;
+        }
+        c->schedule_wake(retry_at);
+    }
+    this->waiting.clear();
+}
+
+unsigned component::add_packet(packet* p, unsigned long wake_at)
+{
+    this->resident_packets.push_back(p);
+    this->resident_wake.push_back(wake_at);
+    this->resident_credit.push_back({NULL, 0});
+    return this->resident_packets.size() - 1;
+}
+
 void component::destroy_packet(unsigned packet_index)
 {
     // remove packet from component
     delete this->resident_packets[packet_index];
+    this->packets_destroyed++;
+    const link_credit& credit = this->resident_credit[packet_index];
+    if (credit.link != NULL)
+        credit.link->return_tokens(credit.flits);
     
     // move the last packet in the buffer to occupy the vacated location
     unsigned last_source_ix = this->resident_packets.size() - 1;
     this->resident_packets[packet_index] = this->resident_packets[last_source_ix];
+    this->resident_wake[packet_index] = this->resident_wake[last_source_ix];
+    this->resident_credit[packet_index] = this->resident_credit[last_source_ix];
     
     this->resident_packets.resize(last_source_ix);
+    this->resident_wake.resize(last_source_ix);
+    this->resident_credit.resize(last_source_ix);
+    
+    // a slot just opened up
+    this->request_generate(this->get_time());
+    this->release_waiting();
 }
 
-unsigned component::min_packet_cooldown() const
+unsigned long component::min_packet_wake() const
 {
     // note that this function needs to work when there are 0 resident packets
-    unsigned min_cooldown = UINT_MAX;
-    unsigned num_resident_packets = this->resident_packets.size();
-    for (unsigned ix = 0; ix < num_resident_packets; ix++)
+    return find_min(this->resident_wake.data(), this->resident_wake.size());
+}
+
+unsigned component::min_packet_cooldown() const
+{
+    unsigned long min_wake = this->min_packet_wake();
+    if (min_wake >= NEVER)
+        return UINT_MAX;
+    unsigned long now = this->get_time();
+    return min_wake <= now ? 0 : (unsigned)(min_wake - now);
+}
+
+void component::schedule_wake(unsigned long wake_at)
+{
+    if (wake_at >= this->next_wake)
+        return;
+    this->next_wake = wake_at;
+    if (this->driver != NULL)
+        this->driver->schedule(this);
+}
+
+void component::refresh_wake()
+{
+    unsigned long min_wake = this->min_packet_wake();
+    // blocked packets are woken by release_waiting(), not the event queue
+    this->next_wake = min_wake >= NEVER ? ULONG_MAX : min_wake;
+}
+
+void component::request_generate(unsigned long time, bool timed)
+{
+    if (timed && time < this->generate_deadline)
+        this->generate_deadline = time;
+    if (time >= this->generate_at)
+        return;
+    this->generate_at = time;
+    if (this->driver != NULL)
+        this->driver->activate(this);
+}
+
+unsigned long component::get_time() const
+{
+    if (this->driver == NULL)
+        return 0;
+    return this->driver->get_time();
+}
+
+std::string component::packet_name(const packet* p) const
+{
+    
+    static const char* const type_names[] =
     {
-        unsigned c = this->resident_packets[ix]->cooldown;
-        if (c < min_cooldown)
-            min_cooldown = c;
-    }
-    return min_cooldown;
+        "invalid",
+        "read",
+        "read response",
+        "write",
+        "swap request",
+        "swap transfer",
+        "swap ack"
+    };
+    
+    // e.g. "CPU0 read 7ffd1a40" or "Global Migration Controller swap ack 2000 tag 3"
+    const component* source = this->lookup(p->original_source);
+    std::ostringstream name;
+    name
+        << (source == NULL ? "?" : source->name)
+        << ' '
+        << type_names[p->type]
+        << ' '
+        << std::hex << p->address << std::dec;
+    if (p->type == SWAP_REQ || p->type == SWAP_XFER || p->type == SWAP_ACK)
+        name << " tag " << p->swap_tag;
+    return name.str();
+    
 }
 
 unsigned component::num_Packets() {
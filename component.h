@@ -13,15 +13,22 @@
 #ifndef __HEADER_GUARD_COMPONENT__
 #define __HEADER_GUARD_COMPONENT__
 
+#include <climits>
 #include <iostream>
 #include <unordered_map>
+#include <utility>
 #include <vector>
+#include "profile.h"
 
+class hmc_link;
 class packet;
+class system_driver;
 
 class component
 {
     
+    friend class system_driver;
+    
     public:
         
         component
@@ -68,25 +75,27 @@ class component
             component* immediate_destination
         );
         
-        /// Typically called by a \ref system_driver object
-        /// Decreases the cooldowns of all resident_packets and
-        /// component::cooldown by time.
-        /// This function should be called on all components in a system
-        /// before any calls to generate() or
-        /// wake_packets() are made.
-        /// \return The lowest cooldown (after the decrease) of the component
-        /// and all resident packets.
-        unsigned advance_cooldowns
-        (
-            /// [in] the amount of time to decrease all cooldown by.
-            /// Since they are unsigned, cooldowns cannot be advanced
-            /// below zero.
-            unsigned time
+        /// Connect this component to neighbor with an \ref hmc_link, so
+        /// that packets sent to neighbor are serialized into FLITs and
+        /// limited by the link's bandwidth and tokens.  The link carries
+        /// packets in one direction only; call add_link on neighbor for
+        /// the other.  Packets sent to a neighbor without a link move
+        /// instantly, as if over an ideal connection.
+        void add_link
+        (
+            /// [in] A component this component has a route through
+            component* neighbor,
+            /// [in] See hmc_link::lanes
+            unsigned lanes = 16,
+            /// [in] See hmc_link::lane_rate
+            unsigned lane_rate = 10,
+            /// [in] See hmc_link::max_tokens
+            unsigned max_tokens = 64
         );
         
         /// Typically called by a \ref system_driver object
         /// This function iteraties through all component::resident_packets
-        /// looking for those whose cooldown reaches zero and calling
+        /// looking for those whose wake time has been reached and calling
         /// either port_out() or retire() when it finds them.
         /// \return The lowest cooldown of all packets whose cooldowns were
         /// changed.  UINT_MAX if no packets woke up, or all the awaken
@@ -95,8 +104,9 @@ class component
         
         /// Used by another component to request that a packet move
         /// into *this
-        /// \return If the packet was accepted, UINT_MAX is returned
-        /// else, returns an estimated minimum wait time before the packet can
+        /// \return If the packet was accepted, UINT_MAX is returned.
+        /// If this component is full, BLOCKED is returned (see block()).
+        /// Else, returns an estimated minimum wait time before the packet can
         /// be accepted.
         virtual unsigned port_in
         (
@@ -130,8 +140,8 @@ class component
         
         /// Typically called by a \ref system_driver object
         ///
-        /// This function should by called by the external system after
-        /// advance_cooldowns() but before wake_packets().  It gives an
+        /// This function should by called by the external system before
+        /// wake_packets() in each step.  It gives an
         /// opportunity for a component to create new packets
         /// from nothing.  It's default behavior is to do nothing.
         ///
@@ -142,6 +152,62 @@ class component
         /// Else, time required to cool down.
         virtual unsigned generate();
         
+        /// Write the timing state of this component and all of its resident
+        /// packets to a binary checkpoint.  Components with more state
+        /// override this and call the base version first.  Packets refer
+        /// to other components by their index in the owning
+        /// \ref system_driver.
+        virtual void save
+        (
+            /// [out] Checkpoint stream opened in binary mode
+            std::ostream& out
+        );
+        
+        /// Replace the state of this component and its resident packets
+        /// with state read back from a checkpoint made by save().
+        /// \return false if the checkpoint is corrupt or was made from a
+        /// different topology.
+        virtual bool restore
+        (
+            /// [in] Checkpoint stream opened in binary mode
+            std::istream& in
+        );
+        
+        /// Used by system_driver::simulate_sampled.  Components which read
+        /// a trace (see \ref cpu) consume up to num_records records
+        /// functionally, without generating packets.  The default
+        /// behavior is to do nothing.
+        /// \return The number of records consumed
+        virtual unsigned long fast_forward(unsigned long num_records);
+        
+        /// \return The number of trace records this component has
+        /// consumed so far, through generate() or fast_forward().  Zero
+        /// for components which do not read a trace.  Used by
+        /// system_driver::simulate_sampled to measure how quickly each
+        /// component gets through its trace.
+        virtual unsigned long get_records_read() const;
+        
+        /// Print any statistics this component keeps of its own, such as
+        /// a \ref cpu "CPU's" cache hit rates.  Called at the end of
+        /// system_driver::simulate.  The default behavior is to print
+        /// nothing.
+        virtual void print_stats
+        (
+            /// [out] Stream to print to
+            std::ostream* file
+        ) const;
+        
+        /// Add the (source, final destination) pairs which need a route
+        /// for this component to work, such as a CPU's requests to the
+        /// devices it accesses, so that system_driver::check_routes can
+        /// report a missing one before the simulation starts.  The
+        /// default behavior is to add none.
+        virtual void required_routes
+        (
+            /// [out] Pairs are appended to this
+            std::vector<std::pair<const component*, const component*> >& routes
+        ) const;
+        
         /// Print the name of this component as well as some info about all
         /// resident packets
         void print
@@ -152,9 +218,33 @@ class component
         
         
         
+        /// Returned by port_in() instead of a cooldown when the component
+        /// has no room for the packet.  The packet does not wake again
+        /// until the component frees a slot, see block().
+        static const unsigned BLOCKED = UINT_MAX - 1;
+        
+        /// \return The index of this component within the owning
+        /// \ref system_driver, which packets use to refer to it
+        inline unsigned get_id() const
+        {
+            return this->id;
+        }
+        
+        /// \return A human readable description of p, formatted from its
+        /// fields.  Packets do not store a name of their own.
+        std::string packet_name(const packet* p) const;
+        
 		/// Returns Current Number of Resident Packets
 		unsigned num_Packets();
         
+        /// \return The number of packets which have been destroyed on this
+        /// component (retired, or replaced by a response) since it was
+        /// constructed.  Not saved in checkpoints.
+        inline unsigned long get_packets_destroyed() const
+        {
+            return this->packets_destroyed;
+        }
+        
         /// A human readable name which is displayed whenever
         /// print() is called
         std::string name;
@@ -165,16 +255,24 @@ class component
 		/// can only be moved through calls to port_in() and
 		/// port_out()
 		std::vector<packet*> resident_packets;
+        
+        /// \return The absolute time (see get_time()) at which
+        /// resident_packets[packet_index] can have another operation
+        /// performed on it, such as routing or retirement.
+        inline unsigned long get_wake(unsigned packet_index) const
+        {
+            return this->resident_wake[packet_index];
+        }
 
     protected:
         
         /// After a component sucessfully accepts a packet through a call
         /// to port_in(), you must wait at least 
         /// component::initiation_interval time ticks before another packet
-        /// can be accepted.  The amount of time remaining before a packet
-        /// may be accepted is stored in component::cooldown.  Note that
-        /// component::cooldown is the minimum time between successful calls
-        /// to port_in() while packet::cooldown is the time before a packet
+        /// can be accepted.  The time at which a packet may next be
+        /// accepted is stored in component::ready_at.  Note that
+        /// component::ready_at limits the rate of successful calls to
+        /// port_in() while component::resident_wake is the time at which a packet
         /// is either routed or retired.
         unsigned initiation_interval;
         
@@ -189,7 +287,7 @@ class component
         /// packets whose final destination is not this component
         /// (packet::destination != this) will be assigned a packet::cooldown
         /// equal to component::routing_latency.  Once this cooldown reaches
-        /// zero, component::routing_table will determine the next
+        /// zero, component::next_hop will determine the next
         /// component the packet should hop to and that component's
         /// port_in() function will be called until the packet is accepted.
         unsigned routing_latency;
@@ -201,13 +299,53 @@ class component
         /// reaches zero, retire() will be called.
         unsigned retirement_latency;
         
+        /// resident_wake[ix] is the absolute time (see get_time()) at which
+        /// resident_packets[ix] wakes.  The wake times are kept apart from
+        /// the packets so that wake_packets() and min_packet_wake() scan
+        /// one contiguous array instead of following a pointer per packet.
+        /// Since they are absolute, nothing needs to happen to them as
+        /// time passes.
+        std::vector<unsigned long> resident_wake;
+        
+        /// The wake time of a packet which was turned away with BLOCKED.
+        /// Kept below 2^63 so that the signed comparisons in
+        /// wake_packets() and min_packet_wake() still order it last.
+        static const unsigned long NEVER = LONG_MAX;
+        
+        /// Components with packets which this component turned away
+        /// because it was full, see block().
+        std::vector<component*> waiting;
+        
+        /// The tokens a resident packet holds on the \ref hmc_link it
+        /// arrived over.  They are returned when the packet leaves.
+        struct link_credit
+        {
+            /// The link, or NULL if the packet did not arrive over one
+            hmc_link* link;
+            unsigned flits;
+        };
+        
+        /// resident_credit[ix] is the link_credit of resident_packets[ix],
+        /// kept in step with it like component::resident_wake
+        std::vector<link_credit> resident_credit;
+        
+        /// Outgoing links added by add_link(), owned by this component
+        std::vector<hmc_link*> links;
+        
+        /// component::links compiled by system_driver::compile_routes,
+        /// indexed by the receiving neighbor's index in the
+        /// \ref system_driver.  Entries are NULL where there is no link,
+        /// and the vector is empty if this component has no links at all.
+        std::vector<hmc_link*> link_to;
+        
+        /// \return The link from this component to neighbor, or NULL
+        hmc_link* find_link(const component* neighbor) const;
+        
         /// See component::initiation_interval.  When a new packet is accepted
-        /// through port_in(), this is the remaining amount of time before the
-        /// component can accept another packet.  It is decreased after
-        /// calls to advance_cooldowns().
-        unsigned cooldown;
-
-		unsigned cycle;
+        /// through port_in(), this is the absolute time (see get_time())
+        /// at which the component can accept another packet.  Nothing
+        /// needs to happen to it as time passes.
+        unsigned long ready_at;
         
         /// Some packets may arrive at this component but only passing
         /// through and need the be routed to the next component along the 
@@ -217,9 +355,18 @@ class component
         /// (through port_in).
         ///
         /// The programmer should initialize this map through calls to
-        /// add_route().
+        /// add_route().  It is only read when the \ref system_driver
+        /// compiles it into component::next_hop.
         std::unordered_map<component*, component*> routing_table;
         
+        /// component::routing_table compiled by
+        /// system_driver::compile_routes before the first simulation step,
+        /// indexed by the final destination's index in the
+        /// \ref system_driver (see packet::final_destination).  This is
+        /// this component's row of the system's next_hop[source][destination]
+        /// table.  Entries are NULL where there is no route.
+        std::vector<component*> next_hop;
+        
         /// Low-level helper function which moves a packet from source to
         /// destination, shrinking source->resident_packets and expanding
         /// destination->resident_packets by 1.
@@ -237,14 +384,137 @@ class component
             component* destination
         );
         
+        /// Offer resident_packets[packet_index] to destination through
+        /// its port_in().  Implementations of port_out() should use this
+        /// rather than calling port_in() directly so that the call is
+        /// profiled.  If there is an \ref hmc_link to destination, the
+        /// packet is only offered once the link is free and has the
+        /// tokens for it, and arrives after it has been serialized.  If
+        /// the packet is turned away, its wake time is set to the time it
+        /// should be offered again, or NEVER if it was BLOCKED.
+        /// \return The result of destination->port_in()
+        unsigned send_packet
+        (
+            /// [in] Index into this->resident_packets
+            unsigned packet_index,
+            /// [in, out] The component which should accept the packet
+            component* destination
+        );
+        
+        /// \return The component which packets refer to by index id (see
+        /// packet::original_source), or NULL if there is none or this
+        /// component is not part of a \ref system_driver.
+        component* lookup(unsigned id) const;
+        
+        /// Called by port_in() when this component is full.  Puts source
+        /// on component::waiting instead of having it retry every tick.
+        /// \return BLOCKED, for port_in() to return
+        unsigned block
+        (
+            /// [in] The component whose packet was turned away
+            component* source
+        );
+        
+        /// Called whenever a slot on this component opens up.  The packets
+        /// every component on component::waiting had blocked wake up again
+        /// at the time they would have retried if they had been polling,
+        /// and the list is emptied.  Components blocked on several full
+        /// components retry all of their blocked packets; those which
+        /// still do not fit block again.
+        void release_waiting();
+        
+        /// Append a new packet to resident_packets.  Components which
+        /// create packets must add them through here so that
+        /// component::resident_wake stays in step.
+        /// \return the packet_index of the new packet
+        unsigned add_packet
+        (
+            /// [in] A packet allocated with new, which this component now owns
+            packet* p,
+            /// [in] Absolute time at which the packet wakes
+            unsigned long wake_at
+        );
+        
         /// Delete (de-allocate memory) resident_packets[packet_index] and
         /// shrink resident_packets by 1.
         void destroy_packet(unsigned packet_index);
         
-        /// Calculate the lowest cooldown for all resident packets but not
-        /// including the component's cooldown.
+        /// \return The lowest wake time of all resident packets, or
+        /// ULONG_MAX if there are none.  NEVER if they are all blocked.
+        unsigned long min_packet_wake() const;
+        
+        /// Calculate the lowest cooldown (time from now until the packet
+        /// wakes) for all resident packets but not including the
+        /// component's own component::ready_at.
         unsigned min_packet_cooldown() const;
         
+        /// Called by port_in() after a packet has been accepted and given
+        /// its new wake time.  Tells the owning \ref system_driver
+        /// that this component may need to be woken earlier than it had
+        /// planned.
+        void schedule_wake
+        (
+            /// [in] Wake time of the newly accepted packet
+            unsigned long wake_at
+        );
+        
+        /// Recalculate component::next_wake from scratch after packets
+        /// have arrived from generate().  wake_packets() keeps
+        /// component::next_wake up to date on its own.
+        void refresh_wake();
+        
+        /// Ask the owning \ref system_driver to call generate() on this
+        /// component at the first step at or after time.  The request is
+        /// forgotten once generate() has been called, so a component which
+        /// wants to keep generating must ask again from inside generate().
+        /// Called automatically whenever a packet arrives or leaves.
+        void request_generate
+        (
+            /// [in] Absolute time, see get_time()
+            unsigned long time,
+            /// [in] Stop the clock at time even if nothing else happens
+            /// then, so generate() is called at exactly that time.
+            /// Otherwise it may be called at the first step after time,
+            /// which is enough for an epoch which only matters once
+            /// packets move again.
+            bool timed = false
+        );
+        
+        /// \return The current simulated time of the owning
+        /// \ref system_driver, or 0 if this component is not part of one.
+        unsigned long get_time() const;
+        
+        /// The \ref system_driver this component was registered with, or
+        /// NULL.  Set by system_driver::add_component().
+        system_driver* driver;
+        
+        /// Index of this component within the owning \ref system_driver
+        unsigned id;
+        
+        /// Smallest wake time of the resident packets,
+        /// or ULONG_MAX if there are no resident packets.  This is the key
+        /// used by the \ref system_driver event queue.
+        unsigned long next_wake;
+        
+        /// Absolute time at which generate() should next be called, or
+        /// ULONG_MAX if this component has nothing to generate until
+        /// a packet arrives or leaves.  See request_generate().
+        unsigned long generate_at;
+        
+        /// Earliest time passed to request_generate() with timed set since
+        /// generate() was last called, or ULONG_MAX.  The
+        /// \ref system_driver does not move the clock past it.
+        unsigned long generate_deadline;
+        
+        /// See get_packets_destroyed()
+        unsigned long packets_destroyed;
+        
+#if PROFILE == 1
+        /// Time spent in each phase of the simulation on this component.
+        /// Printed by system_driver::print_profile
+        profile_counters profile_data;
+#endif
+        
 };
 
 #endif // header guard
@@ -15,6 +15,7 @@
 #include <math.h>
 #include <inttypes.h>
 #include <assert.h>
+#include "checkpoint.h"
 #include "debug.h"
 #include "packet.h"
 #include "component.h"
@@ -73,7 +74,7 @@ controller_global::controller_global
 	this->initiation_interval = initiation_interval_;
 	this->max_resident_packets = max_resident_packets_;
 	this->routing_latency = routing_latency_;
-	this->cooldown = cooldown_;
+	this->ready_at = cooldown_;
 
 	this->first_address = first_address_;
 	this->last_address = last_address_;
@@ -122,7 +123,7 @@ controller_global::~controller_global()
 void controller_global::initialize()
 {
 
-	cycle = 0;
+	epoch_start = 0;
 
 	// Create Table of Memory Pointers
 	numActiveModules = 0;
@@ -164,6 +165,7 @@ void controller_global::add_Module(memory* module) {
 	}
 
 	memModules[numActiveModules] = module;
+	moduleMap.add(module->get_first_address(), module->get_last_address(), numActiveModules);
 	numActiveModules++;
 }
 
@@ -196,8 +198,9 @@ unsigned controller_global::port_in(unsigned packet_index, component* source)
 {
 
 	// make sure the component has not accepted another packet too recently
-	if (this->cooldown > 0)
-		return this->cooldown;
+	unsigned long now = this->get_time();
+	if (this->ready_at > now)
+		return (unsigned)(this->ready_at - now);
 
 	// Allow SWAP_ACK to bypass Capacity Restrictions
 	if (source->resident_packets[packet_index]->type == SWAP_ACK) {
@@ -218,15 +221,12 @@ unsigned controller_global::port_in(unsigned packet_index, component* source)
 
 	// make sure this component is not at its maximum packet capacity
 	if (this->resident_packets.size() >= this->max_resident_packets) {
-		// source->resident_packets[packet_index]->cooldown = 1;
-		return 1; // this->min_packet_cooldown(); // Wait and Try Again
+		return this->block(source);
 	}
 
 	// this component is capable of accepting new packets - move it
-	packet* p = this->resident_packets
-		[
-			this->move_packet(packet_index, source, this)
-		];
+	unsigned ix = this->move_packet(packet_index, source, this);
+	packet* p = this->resident_packets[ix];
 
 	if (p->type == READ_REQ) {
 		load(p);
@@ -237,10 +237,11 @@ unsigned controller_global::port_in(unsigned packet_index, component* source)
 
 	// since this component just accepted a packet, the component
 	// itself needs to cool down before accepting another
-	this->cooldown = this->initiation_interval;
+	this->ready_at = now + this->initiation_interval;
 
 	// packet cooldown is routing latency
-	p->cooldown = this->routing_latency;
+	this->resident_wake[ix] = now + this->routing_latency;
+	this->schedule_wake(this->resident_wake[ix]);
 
 	// the packet has left source, therefore its new cooldown on source
 	// is eternity
@@ -262,7 +263,7 @@ unsigned controller_global::port_out(unsigned packet_index)
 	component* immediate_destination;
 	if (p->type == READ_REQ || p->type == WRITE_REQ) {
 
-		cpu* cpuSource = (cpu*)p->original_source;
+		cpu* cpuSource = (cpu*)this->lookup(p->original_source);
 		unsigned cpu_index = getIndexCPU(cpuSource);
 		unsigned nearest_mem_index = 0;
 
@@ -283,30 +284,28 @@ unsigned controller_global::port_out(unsigned packet_index)
 		immediate_destination = (component*)memModules[0];
 	}
 	else {
-		immediate_destination = this->routing_table[p->final_destination];
+		immediate_destination = this->next_hop[p->final_destination];
 	}
 
-	if (immediate_destination == NULL) {
-		cout << "Error: No Immediate Destination for Packet " << p->name << " At Component: " << this->name << endl;
-		cout << "Press Enter to Exit" << endl;
-		exit((int)getchar());
-	}
+	// system_driver::check_routes has made sure the route exists
+	check
+	(
+		immediate_destination != NULL,
+		"No Immediate Destination for Packet " << this->packet_name(p) << " At Component: " << this->name
+	);
 
-	unsigned new_cooldown = immediate_destination->port_in(packet_index, this);
-	// only assign a new cooldown if the migration failed
-	if (new_cooldown != UINT_MAX)
-		p->cooldown = new_cooldown;
+	unsigned new_cooldown = this->send_packet(packet_index, immediate_destination);
 
 	if (DEBUG) {
 		if (new_cooldown == UINT_MAX)
 		{
 			cout
 				<< "Moved \""
-				<< p->name
+				<< this->packet_name(p)
 				<< "\" from \""
 				<< this->name
 				<< "\" to \""
-				<< this->routing_table[p->final_destination]->name
+				<< immediate_destination->name
 				<< '\"'
 				<< endl;
 		}
@@ -317,29 +316,66 @@ unsigned controller_global::port_out(unsigned packet_index)
 
 unsigned controller_global::generate()
 {
-	
+
+	unsigned long now = this->get_time();
+
 	// Check for the End of Epoch
-	if (cycle >= epoch_length) {
-		// Select Candidates for Migration
-		vector<uint64_t> candidates;
-		candidates = select_Candidates();
-		migrate(candidates);
-
-		// Clear History
-		for (uint64_t i = 0; i < mapTable_size; i++) {
-			for (int j = 0; j < num_cpu; j++) {
-				hTable[i][j] = 0;
-			}
+	if (now - epoch_start >= epoch_length) {
+		unsigned num_migrations = end_Epoch(false);
+		request_generate(epoch_start + epoch_length);
+		if (num_migrations > 0) return 0;
+	}
+
+	// Nothing to do until the end of the Epoch
+	request_generate(epoch_start + epoch_length);
+	return UINT_MAX;
+}
+
+unsigned controller_global::end_Epoch(bool functional)
+{
+	// Select Candidates for Migration
+	vector<uint64_t> candidates;
+	candidates = select_Candidates();
+	migrate(candidates, functional);
+
+	// Clear History
+	for (uint64_t i = 0; i < mapTable_size; i++) {
+		for (int j = 0; j < num_cpu; j++) {
+			hTable[i][j] = 0;
 		}
+	}
 
-		cycle = 0;
-		if (candidates.size() > 0) return 0;
+	epoch_start = this->get_time();
+	return candidates.size();
+}
+
+void controller_global::functional_access(component* source, uint64_t addr, bool write)
+{
+	// Epochs still end on time, the driver moves the clock forward
+	// while fast-forwarding
+	if (this->get_time() - epoch_start >= epoch_length) {
+		end_Epoch(true);
 	}
 
-	return UINT_MAX;
+	uint64_t mem_addr = translate(addr);
+	memory* hmc_dest = find_Destination(mem_addr);
+	if (hmc_dest == NULL) return;
+
+	update_History((cpu*)source, mem_addr);
+	hmc_dest->functional_access(this, mem_addr, write);
+}
+
+uint64_t controller_global::translate(uint64_t addr) const
+{
+	// Same translation as load()
+	uint64_t idx = addr >> this->offset_length;
+	uint64_t nidx_addr = mapTable[idx] << offset_length;
+	uint64_t clr_len = 64 - offset_length;
+	uint64_t offset = (addr << clr_len) >> clr_len;
+	return offset | nidx_addr;
 }
 
-void controller_global::migrate(vector<uint64_t> candidates)
+void controller_global::migrate(vector<uint64_t> candidates, bool functional)
 {
 
 	if (candidates.size() > 0) {
@@ -370,7 +406,7 @@ void controller_global::migrate(vector<uint64_t> candidates)
 					orig_mem_addr = check_idx << offset_length;
 				}
 			}
-			orig_mem = getIndexMEM(find_Destination(orig_mem_addr));
+			orig_mem = find_Destination_Index(orig_mem_addr);
 			uint64_t ideal_dist = distanceTable[ideal_cpu][orig_mem] - 1;
 			if (LINEAR) ideal_mem = orig_mem;
 
@@ -405,7 +441,7 @@ void controller_global::migrate(vector<uint64_t> candidates)
 					orig_mem_addr = check_idx << offset_length;
 				}
 			}
-			ideal_mem = getIndexMEM(find_Destination(ideal_mem_addr));
+			ideal_mem = find_Destination_Index(ideal_mem_addr);
 			
 			
 			memory* swapModule_A = memModules[orig_mem];
@@ -416,33 +452,37 @@ void controller_global::migrate(vector<uint64_t> candidates)
 				tag_count++;
 				unsigned tag = tag_count;
 
-				// Add Packets to Controller
-				packet* migrate_A = new packet
-					(
-						this, // Original source
-						swapModule_A, // Migration Source
-						swapModule_B, // Migration Destination
-						tag,  // Tag
-						SWAP_REQ,
-						0,  // Address
-						4,  // bytes accessed
-						0,  // cooldown
-						"Migrate " + swapModule_A->name + " -> " + swapModule_B->name // name
-					);
-				packet* migrate_B = new packet
-					(
-						this, // Original source
-						swapModule_B, // Migration Source
-						swapModule_A, // Migration Destination
-						tag,  // Tag
-						SWAP_REQ,
-						0,  // Address
-						4,  // bytes accessed
-						0,  // cooldown
-						"Migrate " + swapModule_B->name + " -> " + swapModule_A->name // name
-					);
-				this->resident_packets.push_back(migrate_A);
-				this->resident_packets.push_back(migrate_B);
+				// A functional migration (see end_Epoch) only changes the
+				// mapping, no data is moved and no pages are locked
+				if (!functional) {
+
+					// Add Packets to Controller
+					packet* migrate_A = new packet
+						(
+							this->id, // Original source
+							swapModule_A->get_id(), // Migration Source
+							swapModule_B->get_id(), // Migration Destination
+							tag,  // Tag
+							SWAP_REQ,
+							0,  // Address
+							4,  // bytes accessed
+							this->get_time() // issued at
+						);
+					packet* migrate_B = new packet
+						(
+							this->id, // Original source
+							swapModule_B->get_id(), // Migration Source
+							swapModule_A->get_id(), // Migration Destination
+							tag,  // Tag
+							SWAP_REQ,
+							0,  // Address
+							4,  // bytes accessed
+							this->get_time() // issued at
+						);
+					// no cooldown
+					this->add_packet(migrate_A, this->get_time());
+					this->add_packet(migrate_B, this->get_time());
+				}
 
 				// Swap the two indices in MapTable
 				unsigned old_index;
@@ -465,14 +505,16 @@ void controller_global::migrate(vector<uint64_t> candidates)
 				mapTable[new_index] = old_Value;
 
 				// Add Migration Pages to Locked Page List
-				lockedPage page_A, page_B;
-				page_A.page_idx = old_index;
-				page_A.tag = tag;
-				page_B.page_idx = new_index;
-				page_B.tag = tag;
-
-				locked_Pages.push_back(page_A);
-				locked_Pages.push_back(page_B);
+				if (!functional) {
+					lockedPage page_A, page_B;
+					page_A.page_idx = old_index;
+					page_A.tag = tag;
+					page_B.page_idx = new_index;
+					page_B.tag = tag;
+
+					locked_Pages.push_back(page_A);
+					locked_Pages.push_back(page_B);
+				}
 
 				if (DEBUG) {
 					cout << " \n Performed Migration: " << endl;
@@ -517,10 +559,8 @@ void controller_global::load(packet* p)
 	hmc_dest = (component*) find_Destination(mem_addr);
 
 	// Modify Read Packet
-	string packetName = "R" + std::to_string(addr);
-	//p->name = packetName;
 	p->address = mem_addr;
-	p->final_destination = hmc_dest;
+	p->final_destination = hmc_dest->get_id();
 
 	if (DEBUG) {
 		printf("Load Packet - Original Address: %lx Translated Address: %lx \n", (unsigned long)addr, (unsigned long)mem_addr);
@@ -528,7 +568,7 @@ void controller_global::load(packet* p)
 	}
 
 	// Update History Table
-	update_History((cpu*) p->original_source, mem_addr);
+	update_History((cpu*)this->lookup(p->original_source), mem_addr);
 
 }
 
@@ -562,10 +602,8 @@ void controller_global::store(packet* p)
 	hmc_dest = (component*) find_Destination(mem_addr);
 
 	// Modify Write Packet
-	string packetName = "W" + std::to_string(addr);
-	//p->name = packetName;
 	p->address = mem_addr;
-	p->final_destination = hmc_dest;
+	p->final_destination = hmc_dest->get_id();
 
 	if (DEBUG) {
 		printf("Load Packet - Original Address: %lx Translated Address: %lx \n", (unsigned long)addr, (unsigned long)mem_addr);
@@ -573,7 +611,7 @@ void controller_global::store(packet* p)
 	}
 
 	// Update History Table
-	update_History((cpu*)p->original_source, mem_addr);
+	update_History((cpu*)this->lookup(p->original_source), mem_addr);
 
 }
 
@@ -636,17 +674,24 @@ vector<uint64_t> controller_global::select_Candidates()
 
 memory* controller_global::find_Destination(uint64_t addr) {
 
-	memory* m;
-	for (uint64_t i = 0; i < num_mem; i++) {
-		m = memModules[i];
-		if (m->contains_address(addr)) {
-			return m;
-		}
+	unsigned idx = moduleMap.find(addr);
+	if (idx != address_map::NONE) {
+		return memModules[idx];
 	}
 	cout << "Address " << addr << " out of Range" << endl;
 	return NULL;
 }
 
+unsigned controller_global::find_Destination_Index(uint64_t addr) {
+
+	unsigned idx = moduleMap.find(addr);
+	if (idx != address_map::NONE) {
+		return idx;
+	}
+	cout << "Address " << addr << " out of Range" << endl;
+	return 0;
+}
+
 unsigned controller_global::getIndexMEM(memory * module)
 {
 	
@@ -670,3 +715,133 @@ unsigned controller_global::getIndexCPU(cpu * sourceCPU)
 	cerr << "CPU Not Found in Controller" << endl;
 	return 0;
 }
+
+void controller_global::save(std::ostream& out)
+{
+	component::save(out);
+
+	checkpoint_write(out, epoch_start);
+	checkpoint_write(out, tag_count);
+	checkpoint_write(out, mapTable_size);
+	checkpoint_write(out, num_cpu);
+
+	// Only remapped pages are stored, the rest keep the default mapping
+	uint64_t num_remapped = 0;
+	for (uint64_t i = 0; i < mapTable_size; i++) {
+		if (mapTable[i] != i) num_remapped++;
+	}
+	checkpoint_write(out, num_remapped);
+	for (uint64_t i = 0; i < mapTable_size; i++) {
+		if (mapTable[i] != i) {
+			checkpoint_write(out, i);
+			checkpoint_write(out, mapTable[i]);
+		}
+	}
+
+	// Only non-zero History counters are stored
+	uint64_t num_counters = 0;
+	for (uint64_t i = 0; i < mapTable_size; i++) {
+		for (unsigned j = 0; j < num_cpu; j++) {
+			if (hTable[i][j] != 0) num_counters++;
+		}
+	}
+	checkpoint_write(out, num_counters);
+	for (uint64_t i = 0; i < mapTable_size; i++) {
+		for (unsigned j = 0; j < num_cpu; j++) {
+			if (hTable[i][j] != 0) {
+				checkpoint_write(out, i);
+				checkpoint_write(out, j);
+				checkpoint_write(out, hTable[i][j]);
+			}
+		}
+	}
+
+	uint64_t num_locked = locked_Pages.size();
+	checkpoint_write(out, num_locked);
+	for (uint64_t i = 0; i < num_locked; i++) {
+		checkpoint_write(out, locked_Pages[i].page_idx);
+		checkpoint_write(out, locked_Pages[i].tag);
+	}
+}
+
+bool controller_global::restore(std::istream& in)
+{
+	if (!component::restore(in))
+		return false;
+
+	uint64_t saved_mapTable_size;
+	unsigned saved_num_cpu;
+	if (
+		!checkpoint_read(in, epoch_start) ||
+		!checkpoint_read(in, tag_count) ||
+		!checkpoint_read(in, saved_mapTable_size) ||
+		!checkpoint_read(in, saved_num_cpu)
+	)
+		return false;
+
+	if (saved_mapTable_size != mapTable_size || saved_num_cpu != num_cpu) {
+		cerr << "Error. Checkpoint was made with a different Page Size or Number of CPUs" << endl;
+		return false;
+	}
+
+	// Start from the default mapping and empty History
+	for (uint64_t i = 0; i < mapTable_size; i++) {
+		mapTable[i] = i;
+		for (unsigned j = 0; j < num_cpu; j++) {
+			hTable[i][j] = 0;
+		}
+	}
+
+	uint64_t num_remapped;
+	if (!checkpoint_read(in, num_remapped))
+		return false;
+	for (uint64_t n = 0; n < num_remapped; n++) {
+		uint64_t i;
+		uint64_t value;
+		if (!checkpoint_read(in, i) || !checkpoint_read(in, value) || i >= mapTable_size)
+			return false;
+		mapTable[i] = value;
+	}
+
+	uint64_t num_counters;
+	if (!checkpoint_read(in, num_counters))
+		return false;
+	for (uint64_t n = 0; n < num_counters; n++) {
+		uint64_t i;
+		unsigned j;
+		unsigned count;
+		if (!checkpoint_read(in, i) || !checkpoint_read(in, j) || !checkpoint_read(in, count))
+			return false;
+		if (i >= mapTable_size || j >= num_cpu)
+			return false;
+		hTable[i][j] = count;
+	}
+
+	uint64_t num_locked;
+	if (!checkpoint_read(in, num_locked))
+		return false;
+	locked_Pages.clear();
+	for (uint64_t n = 0; n < num_locked; n++) {
+		lockedPage page;
+		if (!checkpoint_read(in, page.page_idx) || !checkpoint_read(in, page.tag))
+			return false;
+		locked_Pages.push_back(page);
+	}
+
+	return true;
+}
+
+void controller_global::required_routes(std::vector<std::pair<const component*, const component*> >& routes) const
+{
+	for (unsigned c = 0; c < numActiveCPUs; c++)
+		routes.push_back({this, sourceCPUs[c]});
+	for (unsigned m = 0; m < numActiveModules; m++) {
+		routes.push_back({memModules[m], this});
+		for (unsigned c = 0; c < numActiveCPUs; c++)
+			routes.push_back({memModules[m], sourceCPUs[c]});
+		for (unsigned t = 0; t < numActiveModules; t++) {
+			if (t != m)
+				routes.push_back({memModules[m], memModules[t]});
+		}
+	}
+}
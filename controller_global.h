@@ -16,6 +16,7 @@
 
 #include <cstdint>
 #include <vector>
+#include "address_map.h"
 #include "addressable.h"
 #include "memory.h"
 #include "cpu.h"
@@ -118,6 +119,27 @@ public:
 	/// max_resident_packets to at least 4 at construction).
 	unsigned generate();
 
+	/// Translate the address and update the History Table as a load or
+	/// store would, then pass the access on to the destination module.
+	/// Epochs which end while fast-forwarding remap pages without
+	/// sending any swap packets.
+	/// See addressable::functional_access
+	void functional_access(component* source, uint64_t addr, bool write);
+
+	/// Also saves the Mapping Table, History Table, Locked Pages and
+	/// Epoch progress.  See component::save
+	void save(std::ostream& out);
+
+	/// Table sizes must match the controller that made the checkpoint.
+	/// See component::restore
+	bool restore(std::istream& in);
+
+	/// Responses go from every module to every CPU, through this
+	/// controller for the CPUs next to it.  Requests and swaps go from
+	/// module to module, and swap acknowledgements from every module
+	/// back here.  See component::required_routes
+	void required_routes(std::vector<std::pair<const component*, const component*> >& routes) const;
+
 protected:
 
 	/// Initialize Memory Mapping, By Default, The Physical and
@@ -136,12 +158,25 @@ protected:
 	/// Select Candidates for Migration
 	vector<uint64_t> select_Candidates();
 
-	/// Perform a Migration
-	void migrate(vector<uint64_t> candidates);
+	/// Perform a Migration.  A functional migration only updates the
+	/// Mapping Table, no swap packets are sent.
+	void migrate(vector<uint64_t> candidates, bool functional = false);
+
+	/// Select and migrate candidates, clear the History Table and start
+	/// the next Epoch
+	/// \return The number of candidates selected
+	unsigned end_Epoch(bool functional);
+
+	/// Translate a CPU Physical Address to a Memory Address using the
+	/// Mapping Table
+	uint64_t translate(uint64_t addr) const;
 
 	/// Determine Destination Memory Module from Address
 	memory * find_Destination(uint64_t addr);
 
+	/// Index in memModules of the Destination Memory Module of an Address
+	unsigned find_Destination_Index(uint64_t addr);
+
 	/// Helper functions that return Internal Indices
 	unsigned getIndexMEM(memory* module);
 	unsigned getIndexCPU(cpu* sourceCPU);
@@ -158,6 +193,10 @@ protected:
 	memory ** memModules;
 	unsigned numActiveModules;
 
+	/// Address Range of each Memory Module, mapped to its Index in
+	/// memModules
+	address_map moduleMap;
+
 	/// Shared Mapping Table that translates the CPU's
 	/// Physical Address to the controller's current Address mapping
 	uint64_t * mapTable;
@@ -187,6 +226,9 @@ protected:
 	/// Number of Cycles / Epoch
 	unsigned epoch_length;
 
+	/// Time at which the current Epoch started
+	unsigned long epoch_start;
+
 	/// Migration Cost Threshold
 	unsigned cost_threshold;
 	unsigned diff_threshold;
@@ -13,6 +13,7 @@
 #include <math.h>
 #include <inttypes.h>
 #include <assert.h>
+#include "checkpoint.h"
 #include "debug.h"
 #include "packet.h"
 #include "component.h"
@@ -65,13 +66,17 @@ controller_linear::controller_linear
 	this->initiation_interval = initiation_interval_;
 	this->max_resident_packets = max_resident_packets_;
 	this->routing_latency = routing_latency_;
-	this->cooldown = 1;
+	this->ready_at = 1;
 
 	this->address_length = address_length;
 	this->internal_address_length = address_length;
 	this->num_hmc_modules = num_hmc_modules;
 	this->page_size = page_size;
 	this->hmcModules = hmcModules;
+	if (hmcModules != NULL) {
+		for (unsigned i = 0; i < num_hmc_modules; i++)
+			moduleMap.add(hmcModules[i]->get_first_address(), hmcModules[i]->get_last_address(), i);
+	}
 	this->epoch_length = epoch_length;
 	this->migration_threshold = migration_threshold;
 
@@ -120,18 +125,17 @@ unsigned controller_linear::port_in(unsigned packet_index, component* source)
 {
 
 	// make sure the component has not accepted another packet too recently
-	if (this->cooldown > 0)
-		return this->cooldown;
+	unsigned long now = this->get_time();
+	if (this->ready_at > now)
+		return (unsigned)(this->ready_at - now);
 
 	// make sure this component is not at its maximum packet capacity
 	if (this->resident_packets.size() >= this->max_resident_packets)
-		return this->min_packet_cooldown();
+		return this->block(source);
 
 	// this component is capable of accepting new packets - move it
-	packet* p = this->resident_packets
-		[
-			this->move_packet(packet_index, source, this)
-		];
+	unsigned ix = this->move_packet(packet_index, source, this);
+	packet* p = this->resident_packets[ix];
 
 	if (p->type == READ_REQ) {
 		load(p);
@@ -140,15 +144,16 @@ unsigned controller_linear::port_in(unsigned packet_index, component* source)
 		store(p);
 	}
 	else {
-		cout << "Packet of Invalid Type at Controller, Name = " << p->name << endl;
+		cout << "Packet of Invalid Type at Controller, Name = " << this->packet_name(p) << endl;
 	}
 
 	// since this component just accepted a packet, the component
 	// itself needs to cool down before accepting another
-	this->cooldown = this->initiation_interval;
+	this->ready_at = now + this->initiation_interval;
 
 	// packet cooldown is routing latency
-	p->cooldown = this->routing_latency;
+	this->resident_wake[ix] = now + this->routing_latency;
+	this->schedule_wake(this->resident_wake[ix]);
 
 	// the packet has left source, therefore its new cooldown on source
 	// is eternity
@@ -190,7 +195,7 @@ void controller_linear::load(packet* p)
 	string packetName = "R" + std::to_string(addr);
 	//p->name = packetName;
 	p->address = mem_addr;
-	p->final_destination = hmc_dest;
+	p->final_destination = hmc_dest->get_id();
 
 	// Update History Table
 	hTable[nidx] += 1;
@@ -243,7 +248,7 @@ void controller_linear::store(packet* p)
 	string packetName = "W" + std::to_string(addr);
 	//p->name = packetName;
 	p->address = mem_addr;
-	p->final_destination = hmc_dest;
+	p->final_destination = hmc_dest->get_id();
 
 	// Update History Table
 	hTable[nidx] += 1;
@@ -311,51 +316,41 @@ void controller_linear::migrate(unsigned idx) {
 
 component* controller_linear::findDestination(uint64_t addr) {
 
-	memory* m;
-	for (uint64_t i = 0; i < num_hmc_modules; i++) {
-		m = hmcModules[i];
-		if (m->contains_address(addr)) {
-			return (component*)m;
-		}
+	unsigned idx = moduleMap.find(addr);
+	if (idx != address_map::NONE) {
+		return (component*)hmcModules[idx];
 	}
 
 	cout << "Address " << addr << " out of Range" << endl;
+	return NULL;
 }
 
-unsigned controller_linear::advance_cooldowns(unsigned time)
+void controller_linear::save(std::ostream& out)
 {
+	component::save(out);
 
-	this->cycle += time;
-
-	// advance the cooldown for this component
-	if (time < this->cooldown)
-		this->cooldown -= time;
-	else
-		this->cooldown = 0;
-
-	// advance the cooldowns for all resident packets
-	// do not include component cooldown in minima calculation, since
-	// we don't want to get stuck because "a components are ready"
-	unsigned min_cooldown = UINT_MAX;
-	unsigned num_resident_packets = this->resident_packets.size();
-	for (unsigned ix = 0; ix < num_resident_packets; ix++)
-	{
-
-		packet* p = this->resident_packets[ix];
-		unsigned c = p->cooldown;
-
-		if (time < c)
-			c -= time;
-		else
-			c = 0;
-
-		p->cooldown = c;
+	checkpoint_write(out, cycle);
+	checkpoint_write(out, table_size);
+	for (uint64_t i = 0; i < table_size; i++) {
+		checkpoint_write(out, mapTable[i]);
+		checkpoint_write(out, hTable[i]);
+	}
+}
 
-		if (c < min_cooldown)
-			min_cooldown = c;
+bool controller_linear::restore(std::istream& in)
+{
+	unsigned saved_table_size;
+	if (!component::restore(in) || !checkpoint_read(in, cycle) || !checkpoint_read(in, saved_table_size))
+		return false;
 
+	if (saved_table_size != table_size) {
+		cerr << "Error. Checkpoint was made with a different Page Size" << endl;
+		return false;
 	}
 
-	return min_cooldown;
-
-}
\ No newline at end of file
+	for (uint64_t i = 0; i < table_size; i++) {
+		if (!checkpoint_read(in, mapTable[i]) || !checkpoint_read(in, hTable[i]))
+			return false;
+	}
+	return true;
+}
@@ -13,6 +13,7 @@
 
 #include <cstdint>
 #include <vector>
+#include "address_map.h"
 #include "addressable.h"
 #include "memory.h"
 
@@ -86,6 +87,12 @@ public:
 	/// Inherit Port In
 	unsigned port_in(unsigned packet_index, component * source);
 
+	/// Also saves the Mapping and History Tables. See component::save
+	void save(std::ostream& out);
+
+	/// See component::restore
+	bool restore(std::istream& in);
+
 protected:
 
 	/// Initialize Memory Mapping, By Default, The Physical and
@@ -101,8 +108,6 @@ protected:
 	/// Determine Destination HMC Module from Address
 	component* findDestination(uint64_t addr);
 
-	unsigned advance_cooldowns(unsigned time);
-
 	/// Shared Mapping Table that translates the CPU's
 	/// Physical Address to the HMC's current Address mapping
 	uint64_t * mapTable;
@@ -111,6 +116,9 @@ protected:
 	/// Used to assign Destination Component for Packets
 	memory ** hmcModules;
 
+	/// Address Range of each HMC Module, mapped to its Index in hmcModules
+	address_map moduleMap;
+
 	/// Shared History Table that keeps track of Hot Pages
 	unsigned * hTable;
 
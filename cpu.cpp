@@ -15,6 +15,7 @@
 #include <sstream>
 #include <string>
 #include <iomanip>
+#include "checkpoint.h"
 #include "cpu.h"
 #include "debug.h"
 #include "packet.h"
@@ -29,20 +30,108 @@ cpu::cpu
     unsigned routing_latency_,
     unsigned retirement_latency_
 )
-    : trace_file(trace_file_.c_str())
 {
     
-    if (!this->trace_file.good())
+    if (!this->trace_file.open(trace_file_))
+    {
         std::cerr
             << "Error. Failed to open "
             << trace_file_
-            << " for writing"
+            << " for reading"
             << std::endl;
-	this->trace_file; // >> std::hex;
+    }
+	this->shared_trace = NULL;
+	this->initialize
+	(
+		name_,
+		max_Operations_,
+		initiation_interval_,
+		max_resident_packets_,
+		routing_latency_,
+		retirement_latency_
+	);
+    
+}
+
+cpu::cpu
+(
+    const trace* shared_trace_,
+    const std::string& name_,
+	unsigned max_Operations_,
+    unsigned initiation_interval_,
+    unsigned max_resident_packets_,
+    unsigned routing_latency_,
+    unsigned retirement_latency_
+)
+{
+    
+    check(shared_trace_ != NULL, "CPU needs a trace");
+	this->shared_trace = shared_trace_;
+	this->initialize
+	(
+		name_,
+		max_Operations_,
+		initiation_interval_,
+		max_resident_packets_,
+		routing_latency_,
+		retirement_latency_
+	);
+    
+}
+
+cpu::cpu
+(
+    const std::string& name_,
+	unsigned max_Operations_,
+    unsigned initiation_interval_,
+    unsigned max_resident_packets_,
+    unsigned routing_latency_,
+    unsigned retirement_latency_
+)
+{
+    
+	this->shared_trace = NULL;
+	this->initialize
+	(
+		name_,
+		max_Operations_,
+		initiation_interval_,
+		max_resident_packets_,
+		routing_latency_,
+		retirement_latency_
+	);
+    
+}
+
+void cpu::initialize
+(
+	const std::string& name_,
+	unsigned max_Operations_,
+	unsigned initiation_interval_,
+	unsigned max_resident_packets_,
+	unsigned routing_latency_,
+	unsigned retirement_latency_
+){
     
     this->name = name_;
+	this->trace_position = 0;
+	this->shared_trace_ended = false;
 	this->active_Operations = 0;
 	this->max_Operations = max_Operations_;
+	this->records_read = 0;
+	this->rob_size = 0;
+	this->issue_width = 0;
+	this->load_queue_size = 0;
+	this->store_queue_size = 0;
+	this->rob_head = 0;
+	this->loads_queued = 0;
+	this->stores_queued = 0;
+	this->has_next_record = false;
+	this->next_record.address = 0;
+	this->next_record.depends = 0;
+	this->next_record.gap = 0;
+	this->next_record.rw = 'R';
+	this->last_access_at = 0;
     this->initiation_interval = initiation_interval_;
     check(max_resident_packets >= 4, "max_resident_packets_ should be at least 4");
     this->max_resident_packets = max_resident_packets_;
@@ -52,8 +141,10 @@ cpu::cpu
     // generate() will always keep this container full, so we might as well
     // just allocate it now
     this->resident_packets.reserve(max_resident_packets_);
+    this->resident_wake.reserve(max_resident_packets_);
+    this->resident_credit.reserve(max_resident_packets_);
     
-    this->cooldown = 0;
+    this->ready_at = 0;
     
 }
 
@@ -67,23 +158,15 @@ unsigned cpu::generate()
         "max_resident_packets needs to be at least 4"
     );
         
+	if (this->rob_size > 0)
+		return this->generate_core();
+
     // Don't do anything if we've gone through the whole trace already
-	if (!this->trace_file.is_open() || !this->trace_file.good()) {
+	if (this->trace_ended() && !this->has_next_record) {
 		if (DEBUG) std::cout << "Trace Ended" << std::endl;
 		return this->min_packet_cooldown();
 	}
     
-    // This actually should never (rarely) happen but is included for
-    // extra robustness against files that are corrupt but open successfully.
-    if (!this->trace_file.good())
-    {
-        std::cerr
-            << "Error. Failed to read trace file for CPU "
-            << this->name
-            << std::endl;
-        return 0;
-    }
-    
     // If there are more than 3 available spaces for resident packets,
     // read the memory trace to generate read/write packets until there are
     // only 3 empty spaces left.
@@ -97,94 +180,41 @@ unsigned cpu::generate()
         
         unsigned new_size = this->max_resident_packets - 3;
         this->resident_packets.reserve(new_size);
-        for (unsigned ix = this->resident_packets.size(); ix < new_size; ix++)
+        this->resident_wake.reserve(new_size);
+        this->resident_credit.reserve(new_size);
+        while (this->resident_packets.size() < new_size)
         {
             
-            // read a line from trace file
-			std::string line;
-			char rw;
-			std::string reqtype;
-			uint64_t address;
-
-			if (getline(this->trace_file, line)) {
-
-				std::istringstream iss(line);
-				iss >> reqtype; iss >> reqtype; // Skip first two words
-				iss >> reqtype >> std::hex >> address;
-				rw = reqtype.at(0);
-
-				if (rw == 'R') {
-					active_Operations++;
-				}
-				/*
-				else if (rw != 'R' && rw != 'W')
-				{
-					std::cerr
-						<< "Error. CPU "
-						<< this->name
-						<< " Encountered unknown access type '"
-						<< rw
-						<< "'.  While reading memory trace. Only 'R' or 'W' are allowed"
-						<< "\n Line: " << line << std::endl
-						<< std::endl;
-				}
-				*/
+            // read a line from trace file, unless an access is already
+            // waiting for its gap to pass
+			trace_record r;
+			if (this->has_next_record) {
+				r = this->next_record;
+				this->has_next_record = false;
+			}
+			else if (!this->read_record(r))
+				break;
+
+			// the compute before this access has not finished yet
+			unsigned long now = this->get_time();
+			if (r.gap > 0 && this->last_access_at + r.gap > now) {
+				this->next_record = r;
+				this->has_next_record = true;
+				this->request_generate(this->last_access_at + r.gap, true);
+				break;
+			}
+			this->last_access_at = now;
+
+			unsigned latency;
+			access_result result = this->issue_access(r.rw, r.address, 0, latency);
+			if (result == ACCESS_PENDING) {
+				active_Operations++;
+			}
+			else if (result == ACCESS_HIT) {
+				// the next access waits until this one has hit
+				this->request_generate(this->get_time() + latency, true);
+				break;
 			}
-			else break;
-            
-            // if we reached the end of the file or encountered an error on
-            // the previous iteration, don't generate any more packets
-            if (!this->trace_file.good())
-            {
-                this->trace_file.close();
-                break;
-            }
-            
-            // calculate the destination component containing this address
-            addressable* destination = NULL;
-            unsigned num_addressables = this->memory_devices.size();
-            for (unsigned idx = 0; idx < num_addressables; idx++)
-            {
-                if (this->memory_devices[idx]->contains_address(address))
-                {
-                    destination = this->memory_devices[idx];
-                    break;
-                }
-            }
-            if (destination == NULL)
-            {
-                std::cerr
-                    << "Error. Memory address from trace was not within the range of any memories in this CPU "
-                    << this->name
-                    << "'s memory device table"
-                    << std::endl;
-                ix--; // no packet was generated, override for loop increment
-                continue;
-            }
-            
-			std::stringstream hex_addr;
-			hex_addr << std::hex << address;
-			std::string addr_str(hex_addr.str());
-
-            packet* p = new packet
-            (
-                this,           // original source
-                destination,    // memory containing requested data word
-				NULL,
-				0,
-                rw == 'R' ? READ_REQ : WRITE_REQ,
-                address,
-                4,  // bytes accessed
-                0,  // cooldown
-                this->name
-                    + (rw == 'R' ? " read " : " write ")
-                    + addr_str
-                    // name
-            );
-            this->resident_packets.push_back(p);
-
-			if (DEBUG) 
-				std::cout << "Generated \"" << p->name << '\"' << std::endl;
 
         }
         
@@ -196,9 +226,316 @@ unsigned cpu::generate()
     
 }
 
+unsigned cpu::generate_core()
+{
+
+	unsigned long now = this->get_time();
+
+	// retire completed accesses in order
+	unsigned retired = 0;
+	while (retired < this->issue_width && !this->rob.empty() && this->rob_done(this->rob.front(), now))
+	{
+		if (this->rob.front().rw == 'R')
+			this->loads_queued--;
+		else
+			this->stores_queued--;
+		this->rob.pop_front();
+		this->rob_head++;
+		retired++;
+	}
+
+	// dispatch accesses from the trace while the reorder buffer and the
+	// load or store queue have room for them
+	unsigned dispatched = 0;
+	while (dispatched < this->issue_width && this->rob.size() < this->rob_size)
+	{
+		if (!this->has_next_record)
+		{
+			if (!this->read_record(this->next_record))
+				break;
+			this->has_next_record = true;
+		}
+		trace_record& r = this->next_record;
+		if (r.rw == 'R' ? this->loads_queued >= this->load_queue_size : this->stores_queued >= this->store_queue_size)
+			break;
+		if (r.gap > 0 && this->last_access_at + r.gap > now) {
+			// the compute before this access has not finished yet
+			this->request_generate(this->last_access_at + r.gap, true);
+			break;
+		}
+		this->last_access_at = now;
+
+		unsigned long sequence = this->rob_head + this->rob.size();
+		rob_entry e;
+		e.address = r.address;
+		e.producer = r.depends != 0 && r.depends <= sequence
+			? sequence - r.depends
+			: NO_PRODUCER;
+		e.done_at = 0;
+		e.rw = r.rw;
+		e.state = ROB_WAITING;
+		this->rob.push_back(e);
+		if (r.rw == 'R')
+			this->loads_queued++;
+		else
+			this->stores_queued++;
+		this->has_next_record = false;
+		dispatched++;
+	}
+
+	// issue the oldest accesses whose dependencies have completed,
+	// leaving 3 spaces for responses as generate() does
+	unsigned issued = 0;
+	unsigned max_requests = this->max_resident_packets - 3;
+	for
+	(
+		unsigned ix = 0;
+		ix < this->rob.size() && issued < this->issue_width && this->resident_packets.size() < max_requests;
+		ix++
+	){
+		rob_entry& e = this->rob[ix];
+		if (e.state != ROB_WAITING)
+			continue;
+		if
+		(
+			e.producer != NO_PRODUCER &&
+			e.producer >= this->rob_head &&
+			!this->rob_done(this->rob[e.producer - this->rob_head], now)
+		)
+			continue;
+
+		unsigned latency;
+		access_result result = this->issue_access(e.rw, e.address, (unsigned)(this->rob_head + ix), latency);
+		if (result == ACCESS_UNMAPPED)
+		{
+			// an access outside every memory device still has to retire
+			e.state = ROB_DONE;
+			continue;
+		}
+		if (result == ACCESS_HIT)
+		{
+			e.state = ROB_HIT;
+			e.done_at = now + latency;
+			this->request_generate(e.done_at, true);
+		}
+		else
+		{
+			e.state = result == ACCESS_PENDING ? ROB_ISSUED : ROB_DONE;
+		}
+		issued++;
+	}
+
+	// responses arriving and requests leaving call generate() again, only
+	// the width limits need the next tick
+	if (retired == this->issue_width || dispatched == this->issue_width || issued == this->issue_width)
+		this->request_generate(now + 1, true);
+
+	return UINT_MAX;
+
+}
+
+cpu::access_result cpu::issue_access(char rw, uint64_t address, unsigned tag, unsigned& latency)
+{
+
+	unsigned long now = this->get_time();
+	latency = 0;
+	if (this->caches.empty()) {
+		if (!this->send_request(rw == 'R' ? READ_REQ : WRITE_REQ, address, 4, tag, now))
+			return ACCESS_UNMAPPED;
+		return rw == 'R' ? ACCESS_PENDING : ACCESS_POSTED;
+	}
+
+	// look the line up level by level.  Only the L1 holds written data,
+	// the levels below are filled clean.
+	for (unsigned level = 0; level < this->caches.size(); level++) {
+		cache& c = this->caches[level];
+		latency += c.hit_latency;
+		bool writeback;
+		uint64_t victim;
+		bool hit = c.access(address, rw == 'W' && level == 0, writeback, victim);
+		if (writeback)
+			this->write_back(level + 1, victim, now + latency);
+		if (hit)
+			return ACCESS_HIT;
+	}
+
+	// a write fetches the line before writing into it
+	const cache& last = this->caches.back();
+	if (!this->send_request(READ_REQ, last.line_address(address), last.line_bytes, tag, now + latency))
+		return ACCESS_UNMAPPED;
+	return ACCESS_PENDING;
+
+}
+
+bool cpu::send_request(packetType type, uint64_t address, unsigned bytes, unsigned tag, unsigned long send_at)
+{
+
+	// calculate the destination component containing this address
+	addressable* destination = this->find_addressable(address);
+	if (destination == NULL)
+		return false;
+
+	packet* p = new packet
+	(
+		this->id,           // original source
+		destination->get_id(),    // memory containing requested data word
+		packet::NO_COMPONENT,
+		tag,
+		type,
+		address,
+		bytes,
+		this->get_time()    // issued at
+	);
+	this->add_packet(p, send_at);
+
+	if (DEBUG)
+		std::cout << "Generated \"" << this->packet_name(p) << '\"' << std::endl;
+	return true;
+
+}
+
+void cpu::write_back(unsigned level, uint64_t address, unsigned long send_at)
+{
+	if (level < this->caches.size()) {
+		bool writeback;
+		uint64_t victim;
+		this->caches[level].access(address, true, writeback, victim);
+		if (writeback)
+			this->write_back(level + 1, victim, send_at);
+		return;
+	}
+	this->send_request(WRITE_REQ, address, this->caches.back().line_bytes, 0, send_at);
+}
+
+void cpu::add_cache
+(
+	unsigned size_bytes,
+	unsigned ways,
+	unsigned hit_latency,
+	unsigned line_bytes,
+	cache::replacement_policy policy
+){
+	// a hit with no latency would let the simple model read the whole
+	// trace in one tick
+	check(hit_latency > 0, "A cache needs a hit latency of at least 1");
+	this->caches.push_back(cache(size_bytes, ways, line_bytes, hit_latency, policy));
+}
+
+void cpu::print_stats(std::ostream* file) const
+{
+	if (this->caches.empty())
+		return;
+	*file
+		<< std::endl << std::left
+		<< std::setw(30) << "cache"
+		<< std::right
+		<< std::setw(12) << "hits"
+		<< std::setw(12) << "misses"
+		<< std::setw(12) << "hit rate"
+		<< std::setw(12) << "writebacks"
+		<< std::endl;
+	for (unsigned level = 0; level < this->caches.size(); level++) {
+		std::stringstream name;
+		name << this->name << " L" << level + 1;
+		this->caches[level].print(name.str(), file);
+	}
+}
+
+void cpu::set_core
+(
+	unsigned rob_size_,
+	unsigned issue_width_,
+	unsigned load_queue_size_,
+	unsigned store_queue_size_
+){
+	check
+	(
+		rob_size_ == 0 || (issue_width_ > 0 && load_queue_size_ > 0 && store_queue_size_ > 0),
+		"An out-of-order core needs an issue width and load and store queues"
+	);
+	this->rob_size = rob_size_;
+	this->issue_width = issue_width_;
+	this->load_queue_size = load_queue_size_;
+	this->store_queue_size = store_queue_size_;
+}
+
+bool cpu::trace_ended() const
+{
+	if (this->shared_trace != NULL)
+		return this->shared_trace_ended;
+	return !this->trace_file.is_open() || this->trace_file.has_ended();
+}
+
+bool cpu::read_record(trace_record& record)
+{
+	if (this->shared_trace != NULL) {
+		if (this->trace_position >= this->shared_trace->size()) {
+			this->shared_trace_ended = true;
+			return false;
+		}
+		record = (*this->shared_trace)[this->trace_position++];
+		this->records_read++;
+		return true;
+	}
+
+	if (!this->trace_file.is_open() || !this->trace_file.pop(record))
+		return false;
+	this->records_read++;
+	return true;
+}
+
+addressable* cpu::find_addressable(uint64_t address) const
+{
+	unsigned idx = this->device_map.find(address);
+	if (idx != address_map::NONE)
+		return this->memory_devices[idx];
+
+	std::cerr
+		<< "Error. Memory address from trace was not within the range of any memories in this CPU "
+		<< this->name
+		<< "'s memory device table"
+		<< std::endl;
+	return NULL;
+}
+
+unsigned long cpu::fast_forward(unsigned long num_records)
+{
+	unsigned long consumed = 0;
+	trace_record r;
+	while (consumed < num_records)
+	{
+		// an access the out-of-order core read ahead goes first
+		if (this->has_next_record)
+		{
+			r = this->next_record;
+			this->has_next_record = false;
+		}
+		else if (this->trace_ended() || !this->read_record(r))
+			break;
+		consumed++;
+
+		addressable* destination = this->find_addressable(r.address);
+		if (destination != NULL)
+			destination->functional_access(this, r.address, r.rw == 'W');
+	}
+	return consumed;
+}
+
+unsigned long cpu::get_records_read() const
+{
+	return this->records_read;
+}
+
+void cpu::required_routes(std::vector<std::pair<const component*, const component*> >& routes) const
+{
+	for (unsigned d = 0; d < this->memory_devices.size(); d++)
+		routes.push_back({this, this->memory_devices[d]});
+}
+
 void cpu::add_addressable(addressable* a)
 {
     check(a != NULL, "CPU can not register NULL addressable");
+    this->device_map.add(a->get_first_address(), a->get_last_address(), this->memory_devices.size());
     this->memory_devices.push_back(a);
 }
 
@@ -214,43 +551,156 @@ unsigned cpu::port_in(unsigned packet_index, component * source)
 	check(source != NULL, "souce component cannot be NULL");
 
 	// make sure the component has not accepted another packet too recently
-	if (this->cooldown > 0)
-		return this->cooldown;
+	unsigned long now = this->get_time();
+	if (this->ready_at > now)
+		return (unsigned)(this->ready_at - now);
 
 	// make sure this component is not at its maximum packet capacity
 	if (this->resident_packets.size() >= this->max_resident_packets) {
-		// source->resident_packets[packet_index]->cooldown = 1;
-		return 1; //  this->min_packet_cooldown();
+		return this->block(source);
 	}
 
 	// this component is capable of accepting new packets - move it
-	packet* p = this->resident_packets
-		[
-			this->move_packet(packet_index, source, this)
-		];
+	unsigned ix = this->move_packet(packet_index, source, this);
+	packet* p = this->resident_packets[ix];
 
 
 	// Only Responses should reach here
-	if (p->type == READ_RESP) {
+	if (p->type == READ_RESP && this->rob_size > 0) {
+		// the tag holds the low 32 bits of the load's sequence number
+		unsigned ix_rob = p->swap_tag - (unsigned)this->rob_head;
+		if (ix_rob >= this->rob.size() || this->rob[ix_rob].state != ROB_ISSUED)
+			std::cerr << "CPU: Received Response for a Load which is not in Flight" << std::endl;
+		else
+			this->rob[ix_rob].state = ROB_DONE;
+	}
+	else if (p->type == READ_RESP) {
 		if (active_Operations <= 0) std::cerr << "CPU: Received Response when no Loads are in Flight" << std::endl;
 		active_Operations--;
 	}
 	else {
-		std::cerr << "CPU: Illegal Packet Type: " << p->type << std::endl;
+		std::cerr << "CPU: Illegal Packet Type: " << (unsigned)p->type << std::endl;
 	}
 
 	// since this component just accepted a packet, the component
 	// itself needs to cool down before accepting another
-	this->cooldown = this->initiation_interval;
+	this->ready_at = now + this->initiation_interval;
 
-	// calculate new packet cooldown
-	if (p->final_destination == this)
-		p->cooldown = this->retirement_latency;
+	// calculate new packet wake time
+	if (p->final_destination == this->id)
+		this->resident_wake[ix] = now + this->retirement_latency;
 	else
-		p->cooldown = this->routing_latency;
+		this->resident_wake[ix] = now + this->routing_latency;
+	this->schedule_wake(this->resident_wake[ix]);
 
 	// the packet has left source, therefore its new cooldown on source
 	// is eternity
 	return UINT_MAX;
 }
 
+void cpu::save(std::ostream& out)
+{
+	component::save(out);
+
+	// -1 marks a trace which has already been read to the end
+	int64_t offset = -1;
+	if (this->shared_trace != NULL) {
+		if (!this->shared_trace_ended)
+			offset = (int64_t)this->trace_position;
+	}
+	else if (this->trace_file.is_open() && !this->trace_file.has_ended())
+		offset = (int64_t)this->trace_file.tell();
+	checkpoint_write(out, offset);
+	checkpoint_write(out, this->active_Operations);
+
+	// the out-of-order core, empty for the simple model
+	checkpoint_write(out, this->rob_head);
+	checkpoint_write(out, (uint32_t)this->rob.size());
+	for (unsigned ix = 0; ix < this->rob.size(); ix++) {
+		const rob_entry& e = this->rob[ix];
+		checkpoint_write(out, e.address);
+		checkpoint_write(out, e.producer);
+		checkpoint_write(out, e.done_at);
+		checkpoint_write(out, e.rw);
+		checkpoint_write(out, (uint8_t)e.state);
+	}
+	checkpoint_write(out, this->loads_queued);
+	checkpoint_write(out, this->stores_queued);
+	checkpoint_write(out, this->has_next_record);
+	checkpoint_write(out, this->next_record.address);
+	checkpoint_write(out, this->next_record.depends);
+	checkpoint_write(out, this->next_record.gap);
+	checkpoint_write(out, this->next_record.rw);
+	checkpoint_write(out, this->last_access_at);
+
+	for (unsigned level = 0; level < this->caches.size(); level++)
+		this->caches[level].save(out);
+}
+
+bool cpu::restore(std::istream& in)
+{
+	if (!component::restore(in))
+		return false;
+
+	int64_t offset;
+	if (!checkpoint_read(in, offset) || !checkpoint_read(in, this->active_Operations))
+		return false;
+
+	uint32_t rob_entries;
+	if (!checkpoint_read(in, this->rob_head) || !checkpoint_read(in, rob_entries))
+		return false;
+	this->rob.clear();
+	for (uint32_t ix = 0; ix < rob_entries; ix++) {
+		rob_entry e;
+		uint8_t state;
+		if
+		(
+			!checkpoint_read(in, e.address) ||
+			!checkpoint_read(in, e.producer) ||
+			!checkpoint_read(in, e.done_at) ||
+			!checkpoint_read(in, e.rw) ||
+			!checkpoint_read(in, state) ||
+			state > ROB_DONE
+		)
+			return false;
+		e.state = (rob_state)state;
+		this->rob.push_back(e);
+	}
+	if
+	(
+		!checkpoint_read(in, this->loads_queued) ||
+		!checkpoint_read(in, this->stores_queued) ||
+		!checkpoint_read(in, this->has_next_record) ||
+		!checkpoint_read(in, this->next_record.address) ||
+		!checkpoint_read(in, this->next_record.depends) ||
+		!checkpoint_read(in, this->next_record.gap) ||
+		!checkpoint_read(in, this->next_record.rw) ||
+		!checkpoint_read(in, this->last_access_at)
+	)
+		return false;
+
+	for (unsigned level = 0; level < this->caches.size(); level++) {
+		if (!this->caches[level].restore(in))
+			return false;
+	}
+
+	if (this->shared_trace != NULL) {
+		this->shared_trace_ended = offset < 0;
+		if (offset >= 0)
+			this->trace_position = (unsigned long)offset;
+		return this->trace_position <= this->shared_trace->size();
+	}
+
+	if (offset < 0) {
+		this->trace_file.close();
+		return true;
+	}
+
+	// the reader thread starts again from the saved record
+	std::string filename = this->trace_file.get_filename();
+	if (!this->trace_file.open(filename, (unsigned long)offset)) {
+		std::cerr << "Error. CPU " << this->name << " can not resume a trace which failed to open" << std::endl;
+		return false;
+	}
+	return true;
+}
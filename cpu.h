@@ -13,11 +13,16 @@
 #ifndef __HEADER_GUARD_CPU_MODIFIED__
 #define __HEADER_GUARD_CPU_MODIFIED__
 
+#include <deque>
 #include <fstream>
 #include <vector>
 #include <unordered_map>
+#include "address_map.h"
 #include "addressable.h"
+#include "cache.h"
 #include "component.h"
+#include "packet.h"
+#include "trace.h"
 
 class addressable;
 
@@ -26,6 +31,8 @@ class cpu : public component
     
     public:
         
+		/// Construct a CPU which streams a trace file, either text or
+		/// binary (see \ref trace_file)
 		cpu
         (
             /// [in] See \ref trace_file
@@ -44,13 +51,64 @@ class cpu : public component
             unsigned retirement_latency_ = 0
         );
         
+		/// Construct a CPU which reads a trace that has already been
+		/// parsed into memory instead of streaming a file.  The trace is
+		/// only read, so many CPUs (and simulations on other threads) may
+		/// share it.  It must outlive the CPU.
+		cpu
+        (
+            /// [in] See \ref shared_trace
+            const trace* shared_trace_,
+            /// [in] See \ref component::name
+            const std::string& name_ = "Unnamed CPU",
+			/// [in] Maximum number of Loads allowed in flight
+			unsigned max_Operations_ = 4,
+            /// [in] See \ref component::initiation_interval
+            unsigned initiation_interval_ = 0,
+            /// [in] See \ref component::initiation_interval
+            unsigned max_resident_packets_ = 8,
+            /// [in] See \ref component::routing_latency
+            unsigned routing_latency_ = 0,
+            /// [in] See \ref component::retirement_latency
+            unsigned retirement_latency_ = 0
+        );
+        
         /// Read some of the trace_file and generate read / write packets
         /// from the trace.  This function will fill any available spaces
         /// in the resident_packets vector but try to leave at least 3 spaces
         /// available (therefore it is recomended to initialize
-        /// max_resident_packets to at least 4 at construction).
+        /// max_resident_packets to at least 4 at construction).  An access
+        /// is not sent until trace_record::gap ticks after the one before
+        /// it.  With an out-of-order core (see set_core) accesses go through
+        /// its reorder buffer instead, see generate_core().
         unsigned generate();
         
+        /// Model an out-of-order core in front of the memory system
+        /// instead of capping the number of loads in flight at
+        /// max_Operations.  Every access in the trace passes through a
+        /// reorder buffer of rob_size_ accesses: up to issue_width_ are
+        /// dispatched into it, issued to memory and retired in order each
+        /// tick.  Loads and stores also hold an entry of the load or store
+        /// queue from dispatch to retirement.  An access may only issue
+        /// once the access it depends on (see trace_record::depends) has
+        /// completed, so chains of dependent loads are serialized while
+        /// independent ones overlap.  An access is dispatched no sooner
+        /// than trace_record::gap ticks after the one before it, while
+        /// the accesses already in the buffer carry on.  Loads complete
+        /// when their response arrives, stores as soon as they are sent.
+        /// Call before the simulation starts.
+        void set_core
+        (
+            /// [in] See cpu::rob_size, 0 for the simple model
+            unsigned rob_size_,
+            /// [in] See cpu::issue_width
+            unsigned issue_width_ = 4,
+            /// [in] See cpu::load_queue_size
+            unsigned load_queue_size_ = 32,
+            /// [in] See cpu::store_queue_size
+            unsigned store_queue_size_ = 32
+        );
+        
         /// Calling this function gives the CPU the ability to send packets
         /// to these devices as final destinations.  These addressable
         /// components need not be directly connected, the routing table
@@ -64,11 +122,70 @@ class cpu : public component
             addressable* a
         );
 
+        /// Put a private cache level between this CPU and the network,
+        /// below any added before it: the first call adds the L1, the
+        /// second the L2 and so on.  Accesses then only leave the CPU as
+        /// whole line reads when they miss every level (writes fetch the
+        /// line too), and as whole line writes when a dirty line falls out
+        /// of the last level.  A hit costs the hit latencies of the levels
+        /// looked up: the simple model reads no more of the trace until
+        /// then, the out-of-order core (see set_core) completes the access
+        /// then.  Call before the simulation starts.
+        void add_cache
+        (
+            /// [in] Capacity in bytes
+            unsigned size_bytes,
+            /// [in] See cache::ways
+            unsigned ways,
+            /// [in] See cache::hit_latency, at least 1
+            unsigned hit_latency,
+            /// [in] See cache::line_bytes
+            unsigned line_bytes = 64,
+            /// [in] See cache::policy
+            cache::replacement_policy policy = cache::LRU
+        );
+
 		/// Port In for Memory Responses
 		unsigned port_in(unsigned packet_index, component * source);
+
+		/// Prints the counters of each cache level, see add_cache
+		void print_stats(std::ostream* file) const;
+
+		/// Also saves how far through the trace this CPU has read, as a
+		/// number of records, the reorder buffer and the caches.
+		/// See component::save
+		void save(std::ostream& out);
+
+		/// See component::restore
+		bool restore(std::istream& in);
+
+		/// Read up to num_records trace records without generating any
+		/// packets.  Each access is passed to its destination's
+		/// addressable::functional_access instead.
+		/// \return The number of records read
+		unsigned long fast_forward(unsigned long num_records);
+
+		/// See component::get_records_read
+		unsigned long get_records_read() const;
+
+		/// Every memory device this CPU sends requests to must be
+		/// reachable from it.  See component::required_routes
+		void required_routes(std::vector<std::pair<const component*, const component*> >& routes) const;
         
     protected:
         
+		/// Construct a CPU with no trace, for a subclass which makes up
+		/// its own accesses by overriding read_record() and trace_ended()
+		cpu
+        (
+            const std::string& name_,
+			unsigned max_Operations_,
+            unsigned initiation_interval_,
+            unsigned max_resident_packets_,
+            unsigned routing_latency_,
+            unsigned retirement_latency_
+        );
+        
         /// Each CPU object opens a memory trace file in read-only mode
         /// at construction.  Every time generate() is called, a small part
         /// of the memory trace is read and used to inject new read and write
@@ -83,23 +200,212 @@ class cpu : public component
         ///     W 0000FF9E
         /// Means that the CPU will read from address 00001140, then write
         /// to address 3FFFFFFF... etc.  The leading zeros are not required
-        /// but all addresses must be in hex and shall not begin with '0x'.
-        std::ifstream trace_file;
+        /// and all addresses must be in hex.  See parse_trace_line() for
+        /// the other layouts which are accepted.  Binary traces made by
+        /// trace_convert are read too, see binary_trace_reader.
+        ///
+        /// The file is read and decoded ahead of the simulation on a
+        /// thread of its own, see \ref trace_stream.
+        /// Not opened if the CPU was given a \ref shared_trace.
+        trace_stream trace_file;
+        
+        /// A trace parsed in memory which this CPU reads instead of
+        /// trace_file, or NULL.
+        const trace* shared_trace;
+        
+        /// Index in shared_trace of the next record to read
+        unsigned long trace_position;
+        
+        /// Set once reading shared_trace has failed because there are no
+        /// records left, the same point at which trace_file ends.
+        bool shared_trace_ended;
         
         /// This table holds tracks all the memory devices which the CPU can
         /// access and is initialized after construction along with the
         /// \ref routing_table.  For example, when a CPU reads the
-        /// memory trace and generates a read/write packet, the CPU walks
-        /// \ref memory_devices calling each entry's contains_address()
-        /// functions.  If it finds a match with
+        /// memory trace and generates a read/write packet, the CPU looks
+        /// the address up in \ref device_map.  If it finds a match with
         /// the address from the trace, it sends that packet's final
         /// destination and routes it using the routing table.  Otherwise
         /// it prints an error and continues execution.
         std::vector<addressable*> memory_devices;
         
+        /// The address range of each entry in \ref memory_devices, mapped
+        /// to its index there
+        address_map device_map;
+        
+		/// Shared by the constructors
+		void initialize
+		(
+			const std::string& name_,
+			unsigned max_Operations_,
+			unsigned initiation_interval_,
+			unsigned max_resident_packets_,
+			unsigned routing_latency_,
+			unsigned retirement_latency_
+		);
+
+		/// \return true once the last read of the trace has failed
+		virtual bool trace_ended() const;
+
+		/// Read the next access from the trace file or shared trace,
+		/// skipping lines which hold no access
+		/// \return false if there was no access left to read, or none
+		/// to read yet
+		virtual bool read_record
+		(
+			/// [out] The access
+			trace_record& record
+		);
+
+		/// Look up the entry of memory_devices containing address
+		/// \return NULL (and print an error) if there is none
+		addressable* find_addressable(uint64_t address) const;
+
+		/// What became of an access, see issue_access()
+		enum access_result
+		{
+			/// No memory device contains the address
+			ACCESS_UNMAPPED,
+			/// The access hit in a cache
+			ACCESS_HIT,
+			/// A write was sent, nothing comes back
+			ACCESS_POSTED,
+			/// A read was sent, a response will come back
+			ACCESS_PENDING
+		};
+
+		/// Look an access up in the caches (see add_cache) and send
+		/// whatever requests it needs
+		/// \return What became of the access
+		access_result issue_access
+		(
+			/// [in] 'R' or 'W'
+			char rw,
+			/// [in] Address of the access
+			uint64_t address,
+			/// [in] Stored in packet::swap_tag, which read responses
+			/// carry back
+			unsigned tag,
+			/// [out] Ticks spent looking the access up in the caches
+			unsigned& latency
+		);
+
+		/// Create a request and make it resident
+		/// \return false if no memory device contains address
+		bool send_request
+		(
+			/// [in] READ_REQ or WRITE_REQ
+			packetType type,
+			/// [in] Address of the access
+			uint64_t address,
+			/// [in] See packet::bytes_accessed
+			unsigned bytes,
+			/// [in] See issue_access()
+			unsigned tag,
+			/// [in] Absolute time at which the request is sent
+			unsigned long send_at
+		);
+
+		/// Write a dirty line evicted from the level above into cache
+		/// level, or out to memory below the last level
+		void write_back
+		(
+			/// [in] Index in cpu::caches
+			unsigned level,
+			/// [in] Address of the line
+			uint64_t address,
+			/// [in] Absolute time at which a request to memory is sent
+			unsigned long send_at
+		);
+
+		/// generate() for the out-of-order core model, see set_core.
+		/// Retires, dispatches and issues up to cpu::issue_width accesses
+		/// and asks to be called again next tick while any of them is
+		/// limited by the width.
+		unsigned generate_core();
+
 		/// Number of Active Operations & Maximum Operations
 		unsigned active_Operations;
 		unsigned max_Operations;
+
+		/// Number of trace records read so far
+		unsigned long records_read;
+
+		/// Accesses the reorder buffer holds, or 0 if this CPU uses the
+		/// simple model limited by max_Operations
+		unsigned rob_size;
+
+		/// Accesses dispatched, issued and retired at most per tick
+		unsigned issue_width;
+
+		/// Loads and stores which may be between dispatch and retirement
+		unsigned load_queue_size;
+		unsigned store_queue_size;
+
+		/// Progress of an access through the out-of-order core
+		enum rob_state : uint8_t
+		{
+			/// Dispatched, waiting for its dependency or for space to
+			/// issue
+			ROB_WAITING,
+			/// Load sent to memory
+			ROB_ISSUED,
+			/// Hit in a cache, done at rob_entry::done_at
+			ROB_HIT,
+			/// Ready to retire
+			ROB_DONE
+		};
+
+		/// An access in the reorder buffer
+		struct rob_entry
+		{
+			uint64_t address;
+			/// Sequence number (see cpu::rob_head) of the access this
+			/// one waits for, or cpu::NO_PRODUCER
+			unsigned long producer;
+			/// See ROB_HIT
+			unsigned long done_at;
+			char rw;
+			rob_state state;
+		};
+
+		/// \return true if e can retire, and wakes accesses which
+		/// depend on it, at time now
+		inline bool rob_done(const rob_entry& e, unsigned long now) const
+		{
+			return e.state == ROB_DONE || (e.state == ROB_HIT && e.done_at <= now);
+		}
+
+		/// Stored in rob_entry::producer for an access which depends on
+		/// nothing
+		static const unsigned long NO_PRODUCER = ULONG_MAX;
+
+		/// The reorder buffer, oldest access first
+		std::deque<rob_entry> rob;
+
+		/// Sequence number of the access at the front of cpu::rob, the
+		/// number of accesses retired so far.  Read requests carry the
+		/// low 32 bits of their sequence number in packet::swap_tag.
+		unsigned long rob_head;
+
+		/// Entries in use in the load and store queues
+		unsigned loads_queued;
+		unsigned stores_queued;
+
+		/// An access read from the trace which did not fit in the load
+		/// or store queue, or whose trace_record::gap had not passed,
+		/// sent or dispatched first next time
+		trace_record next_record;
+		bool has_next_record;
+
+		/// Time at which the last access was sent (simple model) or
+		/// dispatched (out-of-order core), from which the next access's
+		/// trace_record::gap is counted
+		unsigned long last_access_at;
+
+		/// Private cache levels, L1 first, see add_cache
+		std::vector<cache> caches;
 };
 
 #endif // header guard
@@ -0,0 +1,184 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              hmc_cube.cpp \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#include <sstream>
+#include "debug.h"
+#include "hmc_cube.h"
+#include "packet.h"
+#include "system_driver.h"
+
+hmc_vault::hmc_vault
+(
+    hmc_cube* cube_,
+    unsigned first_address_,
+    unsigned last_address_,
+    const std::string& name_,
+    unsigned tCL,
+    unsigned tRC_
+) : memory(first_address_, last_address_, name_, 1, UINT_MAX, 1, tCL, tRC_)
+{
+    this->cube = cube_;
+}
+
+unsigned hmc_vault::port_out(unsigned packet_index)
+{
+    packet* p = this->resident_packets[packet_index];
+    if (p->original_source == this->id)
+        p->original_source = this->cube->get_id();
+    return this->send_packet(packet_index, this->cube);
+}
+
+void hmc_vault::print_stats(std::ostream* file) const
+{
+    // see hmc_cube::print_stats
+}
+
+hmc_cube::hmc_cube
+(
+    unsigned first_address_,
+    unsigned last_address_,
+    const std::string& name_,
+    unsigned num_vaults_,
+    unsigned block_bytes_,
+    unsigned crossbar_latency_,
+    unsigned initiation_interval_,
+    unsigned max_resident_packets_,
+    unsigned tCL,
+    unsigned tRC_
+) : memory
+(
+    first_address_,
+    last_address_,
+    name_,
+    initiation_interval_,
+    max_resident_packets_,
+    crossbar_latency_,
+    crossbar_latency_
+){
+
+    check(num_vaults_ > 0, "A cube needs at least one vault");
+    check(block_bytes_ > 0, "A cube's blocks must hold at least 1 byte");
+    this->block_bytes = block_bytes_;
+    for (unsigned v = 0; v < num_vaults_; v++)
+    {
+        std::stringstream vault_name;
+        vault_name << name_ << ".V" << v;
+        hmc_vault* vault = new hmc_vault(this, first_address_, last_address_, vault_name.str(), tCL, tRC_);
+        vault->set_interleave(block_bytes_, num_vaults_);
+        this->vaults.push_back(vault);
+        this->add_route(vault, vault);
+    }
+    this->crossing.assign(num_vaults_, 0);
+
+}
+
+void hmc_cube::add_vaults(system_driver* driver)
+{
+    check(this->links.size() <= max_links, "A cube has at most 4 external links");
+    for (unsigned v = 0; v < this->vaults.size(); v++)
+        driver->add_component(this->vaults[v]);
+}
+
+bool hmc_cube::is_crossing(const packet* p) const
+{
+    return
+        (p->type == READ_REQ || p->type == WRITE_REQ) &&
+        p->final_destination == this->id;
+}
+
+unsigned hmc_cube::port_in(unsigned packet_index, component* source)
+{
+
+    const packet* p = source->resident_packets[packet_index];
+    if (!this->is_crossing(p))
+        return component::port_in(packet_index, source);
+
+    unsigned v = this->vault_index(p->address);
+    if (this->crossing[v] >= this->queue_depth)
+        return this->block(source);
+
+    unsigned result = component::port_in(packet_index, source);
+    if (result == UINT_MAX)
+        this->crossing[v]++;
+    return result;
+
+}
+
+unsigned hmc_cube::retire(unsigned packet_index)
+{
+
+    // the crossbar has been crossed, on to the vault.  Until the vault
+    // takes it the packet stays the cube's, so a retry comes back here
+    packet* p = this->resident_packets[packet_index];
+    bool counted = this->is_crossing(p);
+    unsigned v = this->vault_index(p->address);
+    p->final_destination = this->vaults[v]->get_id();
+    unsigned result = this->send_packet(packet_index, this->vaults[v]);
+    if (result != UINT_MAX)
+        p->final_destination = this->id;
+    else if (counted)
+    {
+        // moving the packet woke the sources waiting on the cube before
+        // there was room, wake them again now
+        this->crossing[v]--;
+        this->release_waiting();
+    }
+    return result;
+
+}
+
+bool hmc_cube::restore(std::istream& in)
+{
+    if (!memory::restore(in))
+        return false;
+    this->crossing.assign(this->vaults.size(), 0);
+    for (unsigned ix = 0; ix < this->resident_packets.size(); ix++)
+    {
+        const packet* p = this->resident_packets[ix];
+        if (this->is_crossing(p))
+            this->crossing[this->vault_index(p->address)]++;
+    }
+    return true;
+}
+
+void hmc_cube::functional_access(component* source, uint64_t addr, bool write)
+{
+    this->vault_of(addr)->functional_access(source, addr, write);
+}
+
+void hmc_cube::set_banks(unsigned num_banks_, const dram_timing& timing_)
+{
+    for (unsigned v = 0; v < this->vaults.size(); v++)
+        this->vaults[v]->set_banks(num_banks_, timing_);
+}
+
+void hmc_cube::set_scheduler
+(
+    scheduling_policy policy_,
+    unsigned max_age_,
+    unsigned write_high_,
+    unsigned write_low_,
+    unsigned queue_depth_
+){
+    this->queue_depth = queue_depth_;
+    for (unsigned v = 0; v < this->vaults.size(); v++)
+        this->vaults[v]->set_scheduler(policy_, max_age_, write_high_, write_low_, queue_depth_);
+}
+
+void hmc_cube::print_stats(std::ostream* file) const
+{
+    if (this->vaults[0]->get_num_banks() == 0)
+        return;
+    print_bank_header(file);
+    for (unsigned v = 0; v < this->vaults.size(); v++)
+        this->vaults[v]->print_bank_stats(this->vaults[v]->name, file);
+}
@@ -0,0 +1,180 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              hmc_cube.h \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#ifndef __HEADER_GUARD_HMC_CUBE__
+#define __HEADER_GUARD_HMC_CUBE__
+
+#include <climits>
+#include <string>
+#include <vector>
+#include "memory.h"
+
+class hmc_cube;
+class system_driver;
+
+/// \class hmc_vault
+/// One vault of an \ref hmc_cube: a vault controller and the DRAM stacked
+/// above it.  It is a \ref memory holding every num_vaults-th block of the
+/// cube's addresses (see memory::set_interleave), and its only connection
+/// is the cube's crossbar, so whatever it sends leaves through the cube.
+/// Responses it makes name the cube as their source, so the rest of the
+/// system never sees the vault.
+class hmc_vault : public memory
+{
+
+    public:
+
+        hmc_vault
+        (
+            /// [in] The cube this vault belongs to
+            hmc_cube* cube_,
+            /// [in] See memory::memory
+            unsigned first_address_,
+            unsigned last_address_,
+            const std::string& name_,
+            unsigned tCL,
+            unsigned tRC_
+        );
+
+        /// Send the packet to the cube's crossbar, whatever its final
+        /// destination
+        unsigned port_out(unsigned packet_index);
+
+        /// The cube prints its vaults' statistics
+        void print_stats(std::ostream* file) const;
+
+    protected:
+
+        /// The cube this vault belongs to
+        hmc_cube* cube;
+
+};
+
+/// \class hmc_cube
+/// A whole Hybrid Memory Cube, in place of a single \ref memory module:
+/// the logic layer's crossbar and the vaults behind it (see
+/// \ref hmc_vault).  Addresses are dealt out to the vaults a block at a
+/// time, so consecutive blocks are in different vaults and each vault
+/// schedules its own DRAM banks (see memory::set_banks), in parallel with
+/// the others.  A read, write or swap for the cube crosses the crossbar
+/// to its vault and the response crosses back.  Packets passing through
+/// on their way to another cube are routed by the crossbar without
+/// touching a vault, as they would be by a memory module.  The
+/// \ref hmc_link "links" to the cube's neighbours (see
+/// component::add_link) are its external links, of which it has at most
+/// hmc_cube::max_links.
+///
+/// The cube is a memory so that a \ref controller_global can use it as a
+/// module, but it stores nothing itself.  Its vaults are components of
+/// their own: register them with add_vaults() after the cube.
+class hmc_cube : public memory
+{
+
+    public:
+
+        /// External links a cube has
+        static const unsigned max_links = 4;
+
+        hmc_cube
+        (
+            /// [in] See memory::memory
+            unsigned first_address_,
+            /// [in] See memory::memory
+            unsigned last_address_,
+            /// [in] See component::name.  Vault v is called name_.Vv
+            const std::string& name_ = "Unnamed HMC",
+            /// [in] Number of vaults
+            unsigned num_vaults_ = 16,
+            /// [in] See hmc_cube::block_bytes
+            unsigned block_bytes_ = 128,
+            /// [in] Ticks a packet takes across the crossbar, both to a
+            /// vault and passing through.  See component::routing_latency
+            unsigned crossbar_latency_ = 4,
+            /// [in] See component::initiation_interval
+            unsigned initiation_interval_ = 0,
+            /// [in] See component::max_resident_packets
+            unsigned max_resident_packets_ = UINT_MAX,
+            /// [in] tCL of each vault, see memory::memory
+            unsigned tCL = 32,
+            /// [in] tRC of each vault, see memory::memory
+            unsigned tRC_ = 4
+        );
+
+        /// Register the vaults with driver, after the cube itself.  The
+        /// driver then deletes them along with the cube.
+        void add_vaults(system_driver* driver);
+
+        /// As memory::port_in, a read or write for the cube waits while
+        /// the crossbar already holds memory::queue_depth of them for
+        /// its vault, so a vault whose banks are behind holds its requests
+        /// back at their source rather than in the cube
+        unsigned port_in(unsigned packet_index, component* source);
+
+        /// Hand a read, write or swap for the cube on to its vault
+        unsigned retire(unsigned packet_index);
+
+        /// Also counts the reads and writes in the crossbar again.  See
+        /// memory::restore
+        bool restore(std::istream& in);
+
+        /// See memory::functional_access
+        void functional_access(component* source, uint64_t addr, bool write);
+
+        /// Split every vault into banks instead.  See memory::set_banks
+        void set_banks(unsigned num_banks_, const dram_timing& timing_ = default_dram_timing());
+
+        /// Choose how every vault picks its next request, and how many
+        /// requests the crossbar holds for each.  See memory::set_scheduler
+        void set_scheduler
+        (
+            scheduling_policy policy_,
+            unsigned max_age_ = 2000,
+            unsigned write_high_ = 32,
+            unsigned write_low_ = 16,
+            unsigned queue_depth_ = 32
+        );
+
+        /// Print the row hits, misses and conflicts of each vault
+        void print_stats(std::ostream* file) const;
+
+        /// \return The index of the vault holding address
+        inline unsigned vault_index(uint64_t address) const
+        {
+            return (unsigned)((address / this->block_bytes) % this->vaults.size());
+        }
+
+        /// \return The vault holding address
+        inline hmc_vault* vault_of(uint64_t address) const
+        {
+            return this->vaults[this->vault_index(address)];
+        }
+
+    protected:
+
+        /// Bytes of each block dealt out to the vaults, the low address
+        /// bits below the vault number
+        unsigned block_bytes;
+
+        /// The vaults, deleted by the \ref system_driver they were added
+        /// to
+        std::vector<hmc_vault*> vaults;
+
+        /// Reads and writes in the crossbar, not yet taken by each vault
+        std::vector<unsigned> crossing;
+
+        /// \return true if p is a read or write the cube will hand to a
+        /// vault, rather than passing through
+        bool is_crossing(const packet* p) const;
+
+};
+
+#endif // header guard
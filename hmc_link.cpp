@@ -0,0 +1,111 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              hmc_link.cpp \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#include <climits>
+#include <iomanip>
+#include <iostream>
+#include "component.h"
+#include "debug.h"
+#include "hmc_link.h"
+#include "packet.h"
+
+hmc_link::hmc_link
+(
+    component* source_,
+    component* destination_,
+    unsigned lanes_,
+    unsigned lane_rate_,
+    unsigned max_tokens_
+){
+    check(source_ != NULL && destination_ != NULL, "A link needs a component at each end");
+    check(lanes_ > 0 && lane_rate_ > 0, "A link needs at least one lane moving at least one bit per tick");
+    check(max_tokens_ > 0, "A link needs at least one token");
+    this->source = source_;
+    this->destination = destination_;
+    this->lanes = lanes_;
+    this->lane_rate = lane_rate_;
+    this->max_tokens = max_tokens_;
+    this->tokens = max_tokens_;
+    this->free_at = 0;
+    this->packets_sent = 0;
+    this->flits_sent = 0;
+    this->busy_ticks = 0;
+    this->busy_stalls = 0;
+    this->token_stalls = 0;
+}
+
+unsigned hmc_link::flits(const packet* p)
+{
+    // requests without data, swap requests and acknowledgements are
+    // a lone header and tail
+    if (p->type != WRITE_REQ && p->type != READ_RESP && p->type != SWAP_XFER)
+        return 1;
+    return 1 + (p->bytes_accessed + FLIT_BYTES - 1) / FLIT_BYTES;
+}
+
+unsigned hmc_link::serialization_ticks(unsigned num_flits) const
+{
+    unsigned long bits = (unsigned long)num_flits * FLIT_BYTES * 8;
+    unsigned long bits_per_tick = (unsigned long)this->lanes * this->lane_rate;
+    return (unsigned)((bits + bits_per_tick - 1) / bits_per_tick);
+}
+
+unsigned hmc_link::check_send(unsigned num_flits, unsigned long now)
+{
+    if (this->free_at > now)
+    {
+        this->busy_stalls++;
+        return (unsigned)(this->free_at - now);
+    }
+    // a packet bigger than the receiver's whole buffer may still go once
+    // the buffer is empty, rather than never
+    if (num_flits > this->tokens && this->tokens < this->max_tokens)
+    {
+        this->token_stalls++;
+        return UINT_MAX;
+    }
+    return 0;
+}
+
+unsigned hmc_link::send(unsigned num_flits, unsigned long now)
+{
+    unsigned ticks = this->serialization_ticks(num_flits);
+    this->tokens = num_flits > this->tokens ? 0 : this->tokens - num_flits;
+    this->free_at = now + ticks;
+    this->packets_sent++;
+    this->flits_sent += num_flits;
+    this->busy_ticks += ticks;
+    return ticks;
+}
+
+void hmc_link::print(unsigned long now, std::ostream* file) const
+{
+    double utilization = now == 0
+        ? 0.0
+        : 100.0 * this->busy_ticks / now;
+    std::ios::fmtflags flags = file->flags();
+    std::streamsize precision = file->precision();
+    *file
+        << std::left
+        << std::setw(30) << this->source->name.substr(0, 29)
+        << std::setw(30) << this->destination->name.substr(0, 29)
+        << std::right
+        << std::setw(12) << this->packets_sent
+        << std::setw(12) << this->flits_sent
+        << std::setw(12) << this->busy_ticks
+        << std::setw(11) << std::fixed << std::setprecision(1) << utilization << '%'
+        << std::setw(12) << this->busy_stalls
+        << std::setw(12) << this->token_stalls
+        << std::endl;
+    file->flags(flags);
+    file->precision(precision);
+}
@@ -0,0 +1,157 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              hmc_link.h \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#ifndef __HEADER_GUARD_HMC_LINK__
+#define __HEADER_GUARD_HMC_LINK__
+
+#include <iostream>
+
+class component;
+class packet;
+
+/// \class hmc_link
+/// One direction of a serial link between two neighbouring
+/// \ref component "components", following the link layer of the HMC 2.x
+/// specification (hmc_spec_2.pdf).  Packets cross the link as 16 byte
+/// FLITs: one FLIT for the header and tail plus the data rounded up to
+/// whole FLITs.  The link serializes one packet at a time over all of its
+/// lanes, so a packet keeps the link busy, and arrives, that many ticks
+/// later than it would over an ideal connection.
+///
+/// Flow control is token based.  The sender holds one token for every
+/// FLIT of space in the receiver's input buffer, spends them when a
+/// packet is sent and gets them back when the packet leaves the
+/// receiver.  A sender which is out of tokens waits on the receiver
+/// like one which found it full (see component::block).
+///
+/// Links are created with component::add_link and are owned by their
+/// sending component.  Packets between components without a link move
+/// over an ideal connection, as they always have.
+class hmc_link
+{
+
+    public:
+
+        hmc_link
+        (
+            /// [in] See hmc_link::source
+            component* source_,
+            /// [in] See hmc_link::destination
+            component* destination_,
+            /// [in] See hmc_link::lanes
+            unsigned lanes_ = 16,
+            /// [in] See hmc_link::lane_rate
+            unsigned lane_rate_ = 10,
+            /// [in] See hmc_link::max_tokens
+            unsigned max_tokens_ = 64
+        );
+
+        /// Bytes in one FLIT (flow unit), the unit in which packets are
+        /// serialized and tokens are counted
+        static const unsigned FLIT_BYTES = 16;
+
+        /// \return The number of FLITs p occupies on a link: a header and
+        /// tail FLIT, plus the data for write requests, read responses and
+        /// swap transfers.
+        static unsigned flits(const packet* p);
+
+        /// \return The number of ticks it takes to serialize num_flits
+        /// FLITs over this link, at least 1
+        unsigned serialization_ticks(unsigned num_flits) const;
+
+        /// \return 0 if a packet of num_flits FLITs can be sent at time
+        /// now, otherwise the number of ticks until the link has finished
+        /// serializing the packet before it, or UINT_MAX if the link is
+        /// free but out of tokens.  Counts the stall in the utilization
+        /// counters.
+        unsigned check_send
+        (
+            /// [in] Size of the packet to send, see flits()
+            unsigned num_flits,
+            /// [in] Current time, see component::get_time
+            unsigned long now
+        );
+
+        /// Spend the tokens for a packet of num_flits FLITs which the
+        /// receiver has accepted and keep the link busy while it is
+        /// serialized.
+        /// \return The number of ticks the packet spends crossing the link
+        unsigned send
+        (
+            /// [in] Size of the packet, see flits()
+            unsigned num_flits,
+            /// [in] Current time, see component::get_time
+            unsigned long now
+        );
+
+        /// Give back the tokens of a packet which has left the receiver's
+        /// input buffer
+        inline void return_tokens(unsigned num_flits)
+        {
+            this->tokens += num_flits;
+            // see check_send() for packets bigger than the whole buffer
+            if (this->tokens > this->max_tokens)
+                this->tokens = this->max_tokens;
+        }
+
+        /// Print the utilization counters of this link on one line
+        void print
+        (
+            /// [in] Simulated time so far (see component::get_time), the
+            /// utilization is measured against
+            unsigned long now,
+            /// [out] Stream to print to
+            std::ostream* file = &(std::cout)
+        ) const;
+
+        /// The component which sends packets over this link and owns it
+        component* source;
+
+        /// The neighbour of hmc_link::source which receives them
+        component* destination;
+
+        /// Number of serial lanes in this direction, 16 for a full width
+        /// HMC link and 8 for a half width one
+        unsigned lanes;
+
+        /// Bits each lane moves per simulated tick.  With a 1.25 GHz
+        /// simulated clock, 10 corresponds to 12.5 Gb/s lanes
+        unsigned lane_rate;
+
+        /// Size of the receiver's input buffer in FLITs, the number of
+        /// tokens the sender holds while the link is idle
+        unsigned max_tokens;
+
+        /// Tokens the sender holds now
+        unsigned tokens;
+
+        /// Absolute time (see component::get_time) at which the link
+        /// finishes serializing the last packet sent
+        unsigned long free_at;
+
+        /// Utilization counters, printed by print().  Not saved in
+        /// checkpoints.
+        unsigned long packets_sent;
+        unsigned long flits_sent;
+        unsigned long busy_ticks;
+
+        /// Number of times a packet could not be sent because the link
+        /// was still serializing the one before
+        unsigned long busy_stalls;
+
+        /// Number of times a packet could not be sent because the sender
+        /// was out of tokens
+        unsigned long token_stalls;
+
+};
+
+#endif // header guard
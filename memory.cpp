@@ -11,12 +11,31 @@
 /// Target architecture:    x86_64 */
 
 #include <cstring>
+#include <iomanip>
 #include <string>
+#include "checkpoint.h"
 #include "component.h"
 #include "debug.h"
 #include "memory.h"
 #include "packet.h"
 
+dram_timing default_dram_timing()
+{
+    dram_timing timing;
+    timing.tRCD = 32;
+    timing.tRP = 32;
+    timing.tRAS = 64;
+    timing.tRC = 96;
+    timing.tRRD = 12;
+    timing.tFAW = 70;
+    timing.tWR = 35;
+    timing.tCCD = 8;
+    timing.tREFI = 9000;
+    timing.tRFC = 370;
+    timing.burst_bytes = 32;
+    return timing;
+}
+
 memory::memory
 (
     unsigned first_address_,
@@ -41,15 +60,199 @@ memory::memory
     this->max_resident_packets = max_resident_packets_;
     this->routing_latency = routing_latency_;
     this->retirement_latency = tCL;
+    this->tCL = tCL;
     this->tRC = tRC_;
     this->rows = rows_;
     this->columns = columns_;
     this->word_size = word_size_;
     
-    this->cooldown = 0;
+    this->ready_at = 0;
     this->row_buffer = UINT_MAX; // compulsory miss on first access
     this->memory_size = rows_ * columns_ * word_size_;
     
+    this->interleave_block = 1;
+    this->interleave_ways = 1;
+    this->timing = default_dram_timing();
+    this->oldest_activate = 0;
+    for (unsigned ix = 0; ix < 4; ix++)
+        this->recent_activates[ix] = NOT_YET;
+    this->next_refresh = 0;
+    this->policy = FR_FCFS;
+    this->max_age = 2000;
+    this->write_high = 32;
+    this->write_low = 16;
+    this->queue_depth = 32;
+    this->queued_writes = 0;
+    this->draining_writes = false;
+    this->row_hits = 0;
+    this->row_misses = 0;
+    this->row_conflicts = 0;
+    this->refreshes = 0;
+    
+}
+
+void memory::set_banks(unsigned num_banks_, const dram_timing& timing_)
+{
+    
+    check(timing_.burst_bytes > 0, "A DRAM burst must move at least 1 byte");
+    this->timing = timing_;
+    dram_bank idle;
+    idle.open_row = NO_ROW;
+    idle.activated_at = NOT_YET;
+    idle.ready_at = 0;
+    idle.precharge_at = 0;
+    this->banks.assign(num_banks_, idle);
+    this->queues.assign(num_banks_, std::vector<queued_request>());
+    this->admitted.assign(num_banks_, 0);
+    this->next_refresh = timing_.tREFI;
+    
+    // bank_access adds tCL once the request reaches its bank
+    this->retirement_latency = num_banks_ > 0 ? 0 : this->tCL;
+    
+}
+
+void memory::set_scheduler
+(
+    scheduling_policy policy_,
+    unsigned max_age_,
+    unsigned write_high_,
+    unsigned write_low_,
+    unsigned queue_depth_
+){
+    check(write_low_ < write_high_, "The low write watermark must be below the high one");
+    check(queue_depth_ > 0, "A bank's queue must hold at least one request");
+    this->policy = policy_;
+    this->max_age = max_age_;
+    this->write_high = write_high_;
+    this->write_low = write_low_;
+    this->queue_depth = queue_depth_;
+}
+
+void memory::set_interleave(unsigned block_bytes_, unsigned ways_)
+{
+    check(block_bytes_ > 0 && ways_ > 0, "An interleave needs blocks of at least 1 byte and at least 1 way");
+    this->interleave_block = block_bytes_;
+    this->interleave_ways = ways_;
+}
+
+unsigned memory::port_in(unsigned packet_index, component* source)
+{
+    
+    const packet* p = source->resident_packets[packet_index];
+    if
+    (
+        this->banks.empty() ||
+        p->final_destination != this->id ||
+        (p->type != READ_REQ && p->type != WRITE_REQ)
+    )
+        return component::port_in(packet_index, source);
+    
+    // wait, as for a full memory, until the bank's queue has room
+    uint64_t row;
+    unsigned bank_index = this->bank_of(p->address, row);
+    if (this->admitted[bank_index] >= this->queue_depth)
+        return this->block(source);
+    
+    unsigned result = component::port_in(packet_index, source);
+    if (result == UINT_MAX)
+        this->admitted[bank_index]++;
+    return result;
+    
+}
+
+unsigned long memory::bank_access(uint64_t address, bool write, unsigned bytes, unsigned long now)
+{
+    
+    uint64_t row;
+    dram_bank& bank = this->banks[this->bank_of(address, row)];
+    
+    unsigned long start = now > bank.ready_at ? now : bank.ready_at;
+    while (this->timing.tREFI > 0 && this->next_refresh <= start)
+    {
+        this->refresh();
+        if (bank.ready_at > start)
+            start = bank.ready_at;
+    }
+    
+    unsigned long command = start;
+    if (bank.open_row == row)
+        this->row_hits++;
+    else
+    {
+        
+        // precharge the open row, if there is one
+        unsigned long activate = start;
+        if (bank.open_row != NO_ROW)
+        {
+            unsigned long precharge = start > bank.precharge_at ? start : bank.precharge_at;
+            activate = precharge + this->timing.tRP;
+            this->row_conflicts++;
+        }
+        else
+            this->row_misses++;
+        
+        // this bank's last ACT, any bank's last ACT and the 4th last
+        unsigned newest_activate = (this->oldest_activate + 3) % 4;
+        unsigned long limits[3] =
+        {
+            after(bank.activated_at, this->timing.tRC),
+            after(this->recent_activates[newest_activate], this->timing.tRRD),
+            after(this->recent_activates[this->oldest_activate], this->timing.tFAW)
+        };
+        for (unsigned ix = 0; ix < 3; ix++)
+        {
+            if (limits[ix] > activate)
+                activate = limits[ix];
+        }
+        
+        this->recent_activates[this->oldest_activate] = activate;
+        this->oldest_activate = (this->oldest_activate + 1) % 4;
+        bank.open_row = row;
+        bank.activated_at = activate;
+        bank.precharge_at = activate + this->timing.tRAS;
+        command = activate + this->timing.tRCD;
+        
+    }
+    
+    unsigned bursts = (bytes + this->timing.burst_bytes - 1) / this->timing.burst_bytes;
+    if (bursts == 0)
+        bursts = 1;
+    unsigned long done = command + (bursts - 1) * this->timing.tCCD + this->tCL;
+    bank.ready_at = command + bursts * this->timing.tCCD;
+    if (write && done + this->timing.tWR > bank.precharge_at)
+        bank.precharge_at = done + this->timing.tWR;
+    return done;
+    
+}
+
+void memory::refresh()
+{
+    
+    // every bank is precharged first, once its last command allows it
+    unsigned long start = this->next_refresh;
+    bool open = false;
+    for (unsigned ix = 0; ix < this->banks.size(); ix++)
+    {
+        const dram_bank& bank = this->banks[ix];
+        if (bank.ready_at > start)
+            start = bank.ready_at;
+        if (bank.open_row != NO_ROW)
+        {
+            open = true;
+            if (bank.precharge_at > start)
+                start = bank.precharge_at;
+        }
+    }
+    
+    unsigned long end = start + (open ? this->timing.tRP : 0) + this->timing.tRFC;
+    for (unsigned ix = 0; ix < this->banks.size(); ix++)
+    {
+        this->banks[ix].open_row = NO_ROW;
+        this->banks[ix].ready_at = end;
+    }
+    this->next_refresh += this->timing.tREFI;
+    this->refreshes++;
+    
 }
 
 unsigned memory::retire(unsigned packet_index)
@@ -71,22 +274,23 @@ unsigned memory::retire(unsigned packet_index)
         "Tried to access memory address beyond this memory's address space"
     );
     
-    static const std::string swap_basename("Swap ");
-    
-
     switch (p->type)
     {
         case READ_REQ:
         {
             
+            // wait for the bank
+            if (!this->banks.empty())
+                return this->enqueue(packet_index);
+            
             // Transform read request into a read response
             // recycle the memory allocated for the read request packet
             // (optimize out a delete ... new pair)
             p->final_destination = p->original_source;
-            p->original_source = this;
+            p->original_source = this->id;
             p->type = READ_RESP;
             
-            // keep p->cooldown at zero, it will be routed immediatly
+            // keep its wake time in the past, it will be routed immediatly
             // since it already suffered a cooldown
             return 0;
             
@@ -95,6 +299,10 @@ unsigned memory::retire(unsigned packet_index)
         case WRITE_REQ:
         {
             
+            // wait for the bank
+            if (!this->banks.empty())
+                return this->enqueue(packet_index);
+            
             // since we're not keeping track of the actual memory contents,
             // we can just accept it and do nothing.
             this->destroy_packet(packet_index);
@@ -113,27 +321,36 @@ unsigned memory::retire(unsigned packet_index)
             
             // I'm assuming that memory access don't stride across multiple
             // rows since I don't give a flying fart right now...
-            unsigned cooldown = p->bytes_accessed * this->retirement_latency / this->word_size;
-            if (!row_buffer_hit(p->address))
+            unsigned cooldown;
+            if (!this->banks.empty())
+            {
+                unsigned long now = this->get_time();
+                cooldown = (unsigned)(this->bank_access(p->address, false, p->bytes_accessed, now) - now);
+            }
+            else
             {
-                cooldown += this->tRC;
-                this->row_buffer = p->address / this->columns;
+                cooldown = p->bytes_accessed * this->retirement_latency / this->word_size;
+                if (!row_buffer_hit(p->address))
+                {
+                    cooldown += this->tRC;
+                    this->row_buffer = this->local_address(p->address) / this->columns;
+                }
             }
             
             packet* outgoing = new packet
             (
                 p->original_source,         // the controller is the source to allow an ack to be sent later
                 p->swap_destination,        // final destination component
-                NULL,                       // swap destinatination (it's already been consumed here)
+                packet::NO_COMPONENT,       // swap destinatination (it's already been consumed here)
                 p->swap_tag,                // tag to help the controller track packets
                 SWAP_XFER,                  // packet type
                 p->address,
                 p->bytes_accessed,          // number of bytes to swap
-                cooldown,                   // simulated time required to assemble the packet
-                swap_basename + std::to_string(p->swap_tag) // human readable name
+                p->issued_at
             );
             
-            this->resident_packets.push_back(outgoing);
+            // cooldown is the simulated time required to assemble the packet
+            this->add_packet(outgoing, this->get_time() + cooldown);
             destroy_packet(packet_index);
             
             return cooldown;
@@ -147,18 +364,21 @@ unsigned memory::retire(unsigned packet_index)
             // controller that initiated the swap.
             packet* ack = new packet
             (
-                this, 
+                this->id,
                 p->original_source,         // the final destination is the controller that initiated the swap
-                NULL,                       // swap destination no longer needed
+                packet::NO_COMPONENT,       // swap destination no longer needed
                 p->swap_tag,
                 SWAP_ACK,
                 p->address,
                 p->bytes_accessed,
-                0,                          // no cooldown
-                swap_basename + std::to_string(p->swap_tag)    // human readable name
+                p->issued_at
             );
             
-            this->resident_packets.push_back(ack);
+            // no cooldown, unless the data has to be written to a bank
+            unsigned long ack_at = this->get_time();
+            if (!this->banks.empty())
+                ack_at = this->bank_access(p->address, true, p->bytes_accessed, ack_at);
+            this->add_packet(ack, ack_at);
             destroy_packet(packet_index);
             
             // we destroyed the packet, cooldown is an eternity
@@ -178,8 +398,288 @@ unsigned memory::retire(unsigned packet_index)
     
 }
 
+unsigned memory::enqueue(unsigned packet_index)
+{
+    
+    unsigned long now = this->get_time();
+    packet* p = this->resident_packets[packet_index];
+    uint64_t row;
+    unsigned bank_index = this->bank_of(p->address, row);
+    std::vector<queued_request>& queue = this->queues[bank_index];
+    
+    // a request joins the queue the first time it wakes, when it arrives
+    bool queued = false;
+    for (unsigned ix = 0; ix < queue.size() && !queued; ix++)
+        queued = queue[ix].request == p;
+    if (!queued)
+    {
+        queued_request r;
+        r.request = p;
+        r.arrived_at = now;
+        queue.push_back(r);
+        if (p->type == WRITE_REQ)
+            this->queued_writes++;
+    }
+    
+    bool write = p->type == WRITE_REQ;
+    if (this->banks[bank_index].ready_at <= now && this->issue(bank_index) == p)
+    {
+        // a write was destroyed, a read waits for its data
+        if (write)
+            return UINT_MAX;
+        unsigned long done = this->resident_wake[this->find_packet(p)];
+        return (unsigned)(done - now);
+    }
+    
+    // try again once the bank can take another request.  Issuing a write
+    // may have moved p.
+    if (packet_index >= this->resident_packets.size() || this->resident_packets[packet_index] != p)
+        packet_index = this->find_packet(p);
+    unsigned long retry_at = this->banks[bank_index].ready_at;
+    this->resident_wake[packet_index] = retry_at;
+    return retry_at <= now ? 0 : (unsigned)(retry_at - now);
+    
+}
+
+const packet* memory::issue(unsigned bank_index)
+{
+    
+    std::vector<queued_request>& queue = this->queues[bank_index];
+    unsigned pick = this->pick_request(bank_index);
+    packet* p = queue[pick].request;
+    queue.erase(queue.begin() + pick);
+    
+    unsigned long now = this->get_time();
+    unsigned packet_index = this->find_packet(p);
+    this->admitted[bank_index]--;
+    if (p->type == WRITE_REQ)
+    {
+        this->queued_writes--;
+        this->bank_access(p->address, true, p->bytes_accessed, now);
+        this->destroy_packet(packet_index);
+        return p;
+    }
+    
+    // the response waits in this memory until its bank has read the
+    // data out
+    p->final_destination = p->original_source;
+    p->original_source = this->id;
+    p->type = READ_RESP;
+    this->resident_wake[packet_index] = this->bank_access(p->address, false, p->bytes_accessed, now);
+    this->release_waiting();
+    return p;
+    
+}
+
+unsigned memory::pick_request(unsigned bank_index)
+{
+    
+    const std::vector<queued_request>& queue = this->queues[bank_index];
+    
+    // nothing overtakes a request which has waited too long
+    if (this->policy == FCFS || this->get_time() - queue[0].arrived_at >= this->max_age)
+        return 0;
+    
+    if (this->queued_writes >= this->write_high)
+        this->draining_writes = true;
+    else if (this->queued_writes <= this->write_low)
+        this->draining_writes = false;
+    
+    // a bank with nothing of the kind wanted serves the other kind
+    bool want_writes = this->draining_writes;
+    bool found = false;
+    for (unsigned ix = 0; ix < queue.size() && !found; ix++)
+        found = (queue[ix].request->type == WRITE_REQ) == want_writes;
+    if (!found)
+        want_writes = !want_writes;
+    
+    // the oldest row hit, or else the oldest
+    uint64_t open_row = this->banks[bank_index].open_row;
+    unsigned oldest = UINT_MAX;
+    for (unsigned ix = 0; ix < queue.size(); ix++)
+    {
+        const packet* p = queue[ix].request;
+        if ((p->type == WRITE_REQ) != want_writes)
+            continue;
+        uint64_t row;
+        this->bank_of(p->address, row);
+        if (row == open_row)
+            return ix;
+        if (oldest == UINT_MAX)
+            oldest = ix;
+    }
+    return oldest;
+    
+}
+
+unsigned memory::find_packet(const packet* p) const
+{
+    unsigned ix = 0;
+    while (this->resident_packets[ix] != p)
+        ix++;
+    return ix;
+}
+
 bool memory::row_buffer_hit(uint64_t address)
 {
-    return (address / this->columns) == row_buffer;
+    return (this->local_address(address) / this->columns) == row_buffer;
+}
+
+void memory::functional_access(component* source, uint64_t addr, bool write)
+{
+    this->row_buffer = this->local_address(addr) / this->columns;
+    if (!this->banks.empty())
+    {
+        uint64_t row;
+        unsigned bank_index = this->bank_of(addr, row);
+        this->banks[bank_index].open_row = row;
+    }
+}
+
+void memory::print_stats(std::ostream* file) const
+{
+    if (this->banks.empty())
+        return;
+    print_bank_header(file);
+    this->print_bank_stats(this->name, file);
+}
+
+void memory::print_bank_header(std::ostream* file)
+{
+    *file
+        << std::endl << std::left
+        << std::setw(30) << "memory"
+        << std::right
+        << std::setw(12) << "row hits"
+        << std::setw(12) << "misses"
+        << std::setw(12) << "conflicts"
+        << std::setw(12) << "hit rate"
+        << std::setw(12) << "refreshes"
+        << std::endl;
+}
+
+void memory::print_bank_stats(const std::string& label, std::ostream* file) const
+{
+    unsigned long accesses = this->row_hits + this->row_misses + this->row_conflicts;
+    double hit_rate = accesses == 0
+        ? 0.0
+        : 100.0 * this->row_hits / accesses;
+    std::ios::fmtflags flags = file->flags();
+    std::streamsize precision = file->precision();
+    *file
+        << std::left
+        << std::setw(30) << label.substr(0, 29)
+        << std::right
+        << std::setw(12) << this->row_hits
+        << std::setw(12) << this->row_misses
+        << std::setw(12) << this->row_conflicts
+        << std::setw(11) << std::fixed << std::setprecision(1) << hit_rate << '%'
+        << std::setw(12) << this->refreshes
+        << std::endl;
+    file->flags(flags);
+    file->precision(precision);
+}
+
+void memory::save(std::ostream& out)
+{
+    component::save(out);
+    checkpoint_write(out, this->row_buffer);
+    checkpoint_write(out, (uint32_t)this->banks.size());
+    for (unsigned ix = 0; ix < this->banks.size(); ix++)
+    {
+        const dram_bank& bank = this->banks[ix];
+        checkpoint_write(out, bank.open_row);
+        checkpoint_write(out, bank.activated_at);
+        checkpoint_write(out, bank.ready_at);
+        checkpoint_write(out, bank.precharge_at);
+    }
+    for (unsigned ix = 0; ix < 4; ix++)
+        checkpoint_write(out, this->recent_activates[ix]);
+    checkpoint_write(out, this->oldest_activate);
+    checkpoint_write(out, this->next_refresh);
+    
+    // queued requests are saved as their index among the resident packets
+    for (unsigned ix = 0; ix < this->queues.size(); ix++)
+    {
+        const std::vector<queued_request>& queue = this->queues[ix];
+        checkpoint_write(out, (uint32_t)queue.size());
+        for (unsigned q = 0; q < queue.size(); q++)
+        {
+            checkpoint_write(out, (uint32_t)this->find_packet(queue[q].request));
+            checkpoint_write(out, queue[q].arrived_at);
+        }
+    }
+    checkpoint_write(out, this->draining_writes);
 }
 
+bool memory::restore(std::istream& in)
+{
+    uint32_t num_banks;
+    if
+    (
+        !component::restore(in) ||
+        !checkpoint_read(in, this->row_buffer) ||
+        !checkpoint_read(in, num_banks) ||
+        num_banks != this->banks.size()
+    )
+        return false;
+    for (unsigned ix = 0; ix < this->banks.size(); ix++)
+    {
+        dram_bank& bank = this->banks[ix];
+        if
+        (
+            !checkpoint_read(in, bank.open_row) ||
+            !checkpoint_read(in, bank.activated_at) ||
+            !checkpoint_read(in, bank.ready_at) ||
+            !checkpoint_read(in, bank.precharge_at)
+        )
+            return false;
+    }
+    for (unsigned ix = 0; ix < 4; ix++)
+    {
+        if (!checkpoint_read(in, this->recent_activates[ix]))
+            return false;
+    }
+    if
+    (
+        !checkpoint_read(in, this->oldest_activate) ||
+        !checkpoint_read(in, this->next_refresh)
+    )
+        return false;
+    
+    // every resident read or write counts against its bank, whether it
+    // had joined the queue or not
+    this->admitted.assign(this->banks.size(), 0);
+    for (unsigned ix = 0; ix < this->resident_packets.size() && !this->banks.empty(); ix++)
+    {
+        const packet* p = this->resident_packets[ix];
+        uint64_t row;
+        if (p->type == READ_REQ || p->type == WRITE_REQ)
+            this->admitted[this->bank_of(p->address, row)]++;
+    }
+    
+    this->queued_writes = 0;
+    for (unsigned ix = 0; ix < this->queues.size(); ix++)
+    {
+        std::vector<queued_request>& queue = this->queues[ix];
+        uint32_t num_queued;
+        if (!checkpoint_read(in, num_queued))
+            return false;
+        queue.resize(num_queued);
+        for (unsigned q = 0; q < num_queued; q++)
+        {
+            uint32_t packet_index;
+            if
+            (
+                !checkpoint_read(in, packet_index) ||
+                !checkpoint_read(in, queue[q].arrived_at) ||
+                packet_index >= this->resident_packets.size()
+            )
+                return false;
+            queue[q].request = this->resident_packets[packet_index];
+            if (queue[q].request->type == WRITE_REQ)
+                this->queued_writes++;
+        }
+    }
+    return checkpoint_read(in, this->draining_writes);
+}
@@ -13,10 +13,46 @@
 #ifndef __HEADER_GUARD_MEMORY__
 #define __HEADER_GUARD_MEMORY__
 
+#include <climits>
 #include <cstdint>
+#include <iostream>
 #include <vector>
 #include "addressable.h"
 
+/// DRAM timing constraints used by a \ref memory split into banks, see
+/// memory::set_banks.  Every value is in ticks.  tCL is the memory's
+/// retirement latency given to its constructor.
+struct dram_timing
+{
+    /// ACT to the first READ or WRITE of the row
+    unsigned tRCD;
+    /// PRE to the next ACT of the same bank
+    unsigned tRP;
+    /// ACT to PRE of the same bank
+    unsigned tRAS;
+    /// ACT to the next ACT of the same bank
+    unsigned tRC;
+    /// ACT to the next ACT of any other bank
+    unsigned tRRD;
+    /// Window in which at most 4 ACTs may be issued
+    unsigned tFAW;
+    /// End of a write's data to PRE of the same bank
+    unsigned tWR;
+    /// READ or WRITE to the next one in the same bank
+    unsigned tCCD;
+    /// Ticks from one refresh to the next, 0 for no refresh
+    unsigned tREFI;
+    /// A refresh to the next ACT of any bank
+    unsigned tRFC;
+    /// Bytes moved by each READ or WRITE, so larger accesses take
+    /// several column commands tCCD apart
+    unsigned burst_bytes;
+};
+
+/// \return Timings of the DRAM dies in an HMC vault, scaled so tCL
+/// (13.75 ns) is the 32 ticks the topology builder gives every memory
+dram_timing default_dram_timing();
+
 /// \class memory
 /// If you are not familiar with how a DRAM is built, these sites may
 /// be helpful to you: \n
@@ -80,8 +116,185 @@ class memory : public addressable
             unsigned packet_index
         );
         
+        /// Also holds back a read or write for a bank whose queue is
+        /// full.  See component::port_in
+        unsigned port_in(unsigned packet_index, component* source);
+        
+        /// Opens the row containing addr in the row buffer.
+        /// See addressable::functional_access
+        void functional_access(component* source, uint64_t addr, bool write);
+        
+        /// How each bank picks the next request from its queue, see
+        /// set_scheduler
+        enum scheduling_policy : uint8_t
+        {
+            /// Oldest first
+            FCFS,
+            /// First ready, first come first served: the oldest request to
+            /// the row already open, or the oldest request if none is.
+            /// Reads go ahead of writes until memory::write_high writes
+            /// are waiting, then writes go first until only
+            /// memory::write_low are left.
+            FR_FCFS
+        };
+        
+        /// Split the memory into num_banks_ banks, each with a row of its
+        /// own open, instead of the single row buffer and flat tRC
+        /// penalty.  Consecutive rows go to consecutive banks.  Reads and
+        /// writes wait in a queue for their bank, which takes the next
+        /// one (see set_scheduler) whenever it can accept a column
+        /// command: a row hit only waits for the bank's previous column
+        /// command, a miss precharges the open row and activates its own
+        /// within the limits of timing_.  Requests to different banks
+        /// overlap, except that activates are held apart by tRRD and tFAW
+        /// and every bank stops for refresh each tREFI.  A read response
+        /// leaves once its data has been read out.  Swaps skip the queues.
+        /// Call before the simulation starts.
+        virtual void set_banks
+        (
+            /// [in] Number of banks, 0 for the single row buffer
+            unsigned num_banks_,
+            /// [in] See \ref dram_timing
+            const dram_timing& timing_ = default_dram_timing()
+        );
+        
+        /// Choose how the banks set up by set_banks pick their next
+        /// request.  The default is FR_FCFS with the default arguments.
+        virtual void set_scheduler
+        (
+            /// [in] See memory::policy
+            scheduling_policy policy_,
+            /// [in] See memory::max_age
+            unsigned max_age_ = 2000,
+            /// [in] See memory::write_high
+            unsigned write_high_ = 32,
+            /// [in] See memory::write_low
+            unsigned write_low_ = 16,
+            /// [in] See memory::queue_depth
+            unsigned queue_depth_ = 32
+        );
+        
+        /// Only hold every ways_-th block of block_bytes_ bytes of the
+        /// address range, as one vault of an \ref hmc_cube does.  Rows
+        /// and banks are then found with the other blocks squeezed out
+        /// of the address.  Call before the simulation starts.
+        void set_interleave
+        (
+            /// [in] See memory::interleave_block
+            unsigned block_bytes_,
+            /// [in] See memory::interleave_ways
+            unsigned ways_
+        );
+        
+        /// \return The number of banks, 0 for the single row buffer
+        inline unsigned get_num_banks() const
+        {
+            return this->banks.size();
+        }
+        
+        /// Print the row hits, misses and conflicts when split into banks
+        void print_stats(std::ostream* file) const;
+        
+        /// Print the column headings of print_bank_stats()
+        static void print_bank_header(std::ostream* file);
+        
+        /// Print the row hits, misses and conflicts on one line
+        void print_bank_stats
+        (
+            /// [in] What to call this memory, for example "M0"
+            const std::string& label,
+            /// [out] Stream to print to
+            std::ostream* file
+        ) const;
+        
+        /// Also saves the row buffer and the banks.  See component::save
+        void save(std::ostream& out);
+        
+        /// See component::restore
+        bool restore(std::istream& in);
+        
     protected:
         
+        /// One bank of a memory split by set_banks
+        struct dram_bank
+        {
+            /// Row open in the bank, or NO_ROW after a precharge
+            uint64_t open_row;
+            /// Time of the last ACT, or NOT_YET
+            unsigned long activated_at;
+            /// Earliest time of the next READ or WRITE
+            unsigned long ready_at;
+            /// Earliest time of the next PRE, held back by tRAS and tWR
+            unsigned long precharge_at;
+        };
+        
+        /// A read or write waiting in its bank's queue
+        struct queued_request
+        {
+            packet* request;
+            /// Time it joined the queue
+            unsigned long arrived_at;
+        };
+        
+        /// dram_bank::open_row of a precharged bank
+        static const uint64_t NO_ROW = UINT64_MAX;
+        
+        /// dram_bank::activated_at of a bank never activated
+        static const unsigned long NOT_YET = ULONG_MAX;
+        
+        /// \return address with the blocks held elsewhere squeezed out,
+        /// see set_interleave
+        inline uint64_t local_address(uint64_t address) const
+        {
+            if (this->interleave_ways <= 1)
+                return address;
+            uint64_t block = address / this->interleave_block;
+            return (block / this->interleave_ways) * this->interleave_block + address % this->interleave_block;
+        }
+        
+        /// \return The bank holding address, with its row in that bank
+        /// in row
+        inline unsigned bank_of(uint64_t address, uint64_t& row) const
+        {
+            uint64_t row_index = this->local_address(address) / this->columns;
+            row = row_index / this->banks.size();
+            return (unsigned)(row_index % this->banks.size());
+        }
+        
+        /// Schedule a read or write of bytes at address on its bank,
+        /// arriving at now, and update the bank for it
+        /// \return The time its last data is read or written
+        unsigned long bank_access(uint64_t address, bool write, unsigned bytes, unsigned long now);
+        
+        /// Called by retire() each time a read or write wakes: the first
+        /// time puts it in its bank's queue.  If the bank is free, issue
+        /// the request set_scheduler picks, which may be another one.
+        /// \return The cooldown of the packet, see component::retire
+        unsigned enqueue(unsigned packet_index);
+        
+        /// Take the next request off the queue of bank_index and give it
+        /// to the bank.  A read becomes its response, which waits until
+        /// the data is out.  A write is destroyed.
+        /// \return The request issued
+        const packet* issue(unsigned bank_index);
+        
+        /// \return The position in the queue of bank_index of the
+        /// request to issue next
+        unsigned pick_request(unsigned bank_index);
+        
+        /// \return The index in component::resident_packets of p
+        unsigned find_packet(const packet* p) const;
+        
+        /// Refresh every bank at memory::next_refresh, or as soon after
+        /// as the banks can be precharged
+        void refresh();
+        
+        /// \return t + delay, or 0 if t is NOT_YET
+        static inline unsigned long after(unsigned long t, unsigned delay)
+        {
+            return t == NOT_YET ? 0 : t + delay;
+        }
+        
         /// The number of bytes in a single row.  Data within a single
         /// column always have consecutive physical addresses
         unsigned columns;
@@ -117,6 +330,69 @@ class memory : public addressable
         /// into the row buffer incurring extra cooldown time.
         bool row_buffer_hit(uint64_t address);
         
+        /// Bytes in each block of the interleave, see set_interleave
+        unsigned interleave_block;
+        
+        /// Number of memories the blocks are dealt out to in turn, 1 when
+        /// this memory holds its whole range
+        unsigned interleave_ways;
+        
+        /// Empty for the single row buffer, see set_banks
+        std::vector<dram_bank> banks;
+        
+        /// See set_banks
+        dram_timing timing;
+        
+        /// The retirement latency given to the constructor.  Requests are
+        /// retired as soon as they arrive once split into banks, and tCL
+        /// is added by bank_access instead.
+        unsigned tCL;
+        
+        /// Times of the last 4 ACTs of any bank, for tFAW and tRRD, and
+        /// the slot of the oldest
+        unsigned long recent_activates[4];
+        unsigned oldest_activate;
+        
+        /// Time the next refresh is due
+        unsigned long next_refresh;
+        
+        /// Reads and writes waiting for each bank, oldest first
+        std::vector<std::vector<queued_request> > queues;
+        
+        /// See scheduling_policy
+        scheduling_policy policy;
+        
+        /// Ticks after which a request is served before anything which
+        /// arrived after it, however the policy would order them
+        unsigned max_age;
+        
+        /// Writes waiting in all the queues at which FR_FCFS starts
+        /// serving writes first, and at which it goes back to reads
+        unsigned write_high;
+        unsigned write_low;
+        
+        /// Reads and writes each bank takes in before it is full and
+        /// port_in blocks anything else for it
+        unsigned queue_depth;
+        
+        /// Reads and writes resident for each bank, whether they are in
+        /// its queue yet or still on their way to it
+        std::vector<unsigned> admitted;
+        
+        /// Writes waiting in all the queues
+        unsigned queued_writes;
+        
+        /// true while FR_FCFS is serving writes first
+        bool draining_writes;
+        
+        /// Accesses to the open row, to a precharged bank and to a bank
+        /// with another row open, and refreshes.  Not saved in
+        /// checkpoints.
+        unsigned long row_hits;
+        unsigned long row_misses;
+        unsigned long row_conflicts;
+        unsigned long refreshes;
+        
 };
 
 #endif // header guard
@@ -10,31 +10,197 @@
 ///							Windows 7 \n
 /// Target architecture:    x86_64 */
 
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
 #include "packet.h"
 
-class component;
+#ifdef _WIN32
+    #include <malloc.h>
+#endif
+
+namespace
+{
+    
+    struct packet_pool;
+    
+    /// An unused slot in the packet pool
+    struct free_slot
+    {
+        free_slot* next;
+    };
+    
+    /// Slabs are allocated at this size and alignment, so the header of
+    /// the slab a slot belongs to is found by masking the slot's address
+    const std::size_t slab_bytes = 64 * 1024;
+    
+    /// Size of one slot, big enough for either a packet or a free_slot
+    const std::size_t slot_size = sizeof(packet) > sizeof(free_slot)
+        ? sizeof(packet)
+        : sizeof(free_slot);
+    
+    /// Kept in the first slot of every slab (a slot holds a pointer)
+    struct slab_header
+    {
+        /// The pool which carved the slab.  Its slots always go back to it.
+        packet_pool* owner;
+    };
+    
+    /// Free lists used by one thread at a time.  Pools are never freed, so
+    /// a slot can always be handed back to its owner.
+    struct packet_pool
+    {
+        
+        /// Slots only the thread using this pool may touch
+        free_slot* free_list = NULL;
+        
+        /// Slots deleted by other threads.  They push onto this list
+        /// without a lock and the owning thread takes the whole list at
+        /// once, so a popped entry can never be pushed back under it.
+        std::atomic<free_slot*> returned;
+        
+        /// Next pool on the orphan list
+        packet_pool* next_orphan = NULL;
+        
+        packet_pool() : returned(NULL) {}
+        
+        /// Fill the free list, from the slots other threads gave back if
+        /// there are any or else from a new slab
+        void refill()
+        {
+            this->free_list = this->returned.exchange(NULL, std::memory_order_acquire);
+            if (this->free_list != NULL)
+                return;
+            
+            char* slab;
+#ifdef _WIN32
+            slab = (char*)_aligned_malloc(slab_bytes, slab_bytes);
+#else
+            if (posix_memalign((void**)&slab, slab_bytes, slab_bytes) != 0)
+                slab = NULL;
+#endif
+            if (slab == NULL)
+                throw std::bad_alloc();
+            ((slab_header*)slab)->owner = this;
+            for (std::size_t offset = slot_size; offset + slot_size <= slab_bytes; offset += slot_size)
+            {
+                free_slot* slot = (free_slot*)(slab + offset);
+                slot->next = this->free_list;
+                this->free_list = slot;
+            }
+        }
+        
+        /// Called from any thread to give back a slot carved by this pool
+        void give_back(free_slot* slot)
+        {
+            slot->next = this->returned.load(std::memory_order_relaxed);
+            while (!this->returned.compare_exchange_weak(slot->next, slot, std::memory_order_release, std::memory_order_relaxed))
+            {
+                // slot->next now holds the new head, try again
+            }
+        }
+        
+    };
+    
+    /// Pools of threads which have exited, waiting for a new thread to
+    /// take them over along with any slots still coming back to them
+    std::mutex orphan_mutex;
+    packet_pool* orphan_pools = NULL;
+    
+    /// The pool of the calling thread, made on its first allocation
+    struct pool_handle
+    {
+        
+        packet_pool* pool = NULL;
+        
+        ~pool_handle()
+        {
+            if (this->pool == NULL)
+                return;
+            std::lock_guard<std::mutex> lock(orphan_mutex);
+            this->pool->next_orphan = orphan_pools;
+            orphan_pools = this->pool;
+            this->pool = NULL;
+        }
+        
+        packet_pool* get()
+        {
+            if (this->pool != NULL)
+                return this->pool;
+            {
+                std::lock_guard<std::mutex> lock(orphan_mutex);
+                this->pool = orphan_pools;
+                if (this->pool != NULL)
+                    orphan_pools = this->pool->next_orphan;
+            }
+            if (this->pool == NULL)
+                this->pool = new packet_pool();
+            return this->pool;
+        }
+        
+    };
+    
+    thread_local pool_handle local;
+    
+}
 
 packet::packet
 (
-    component* original_source_,
-    component* final_destination_,
-	component* swap_destination_,
-	unsigned swap_tag_,
+    unsigned original_source_,
+    unsigned final_destination_,
+    unsigned swap_destination_,
+    unsigned swap_tag_,
     packetType type_,
     uint64_t address_,
     unsigned bytes_accessed_,
-    unsigned cooldown_,
-    const std::string& name_
+    unsigned long issued_at_
 ){
     
     this->original_source = original_source_;
     this->final_destination = final_destination_;
-	this->swap_destination = swap_destination_;
-	this->swap_tag = swap_tag_;
+    this->swap_destination = swap_destination_;
+    this->swap_tag = swap_tag_;
     this->type = type_;
-    this->name = name_;
     this->address = address_;
+    this->issued_at = issued_at_;
     this->bytes_accessed = bytes_accessed_;
-    this->cooldown = cooldown_;
     
 }
+
+void* packet::operator new(std::size_t size)
+{
+    // a class derived from packet would not fit in a slot
+    if (size != sizeof(packet))
+        return ::operator new(size);
+    
+    packet_pool* pool = local.get();
+    if (pool->free_list == NULL)
+        pool->refill();
+    free_slot* slot = pool->free_list;
+    pool->free_list = slot->next;
+    return slot;
+}
+
+void packet::operator delete(void* p, std::size_t size)
+{
+    if (p == NULL)
+        return;
+    if (size != sizeof(packet))
+    {
+        ::operator delete(p);
+        return;
+    }
+    
+    // slots from another thread's pool go back to it
+    free_slot* slot = (free_slot*)p;
+    packet_pool* owner = ((slab_header*)((uintptr_t)p & ~(uintptr_t)(slab_bytes - 1)))->owner;
+    if (owner != local.pool)
+    {
+        owner->give_back(slot);
+        return;
+    }
+    slot->next = owner->free_list;
+    owner->free_list = slot;
+}
@@ -14,13 +14,10 @@
 #define __HEADER_GUARD_PACKET__
 
 #include <climits>
+#include <cstddef>
 #include <cstdint>
-#include <string>
-#include <vector>
 
-class component;
-
-typedef enum
+typedef enum : uint8_t
 {
     
     /// Packet is in a valid but undefined state
@@ -63,11 +60,11 @@ class packet
         packet
         (
             /// [in] See \ref original_source
-            component* original_source_,
+            unsigned original_source_,
             /// [in] see \ref final_destination
-            component* final_destination_,
-            /// [in] Swap Destination
-            component* swap_destination_,
+            unsigned final_destination_,
+            /// [in] see \ref swap_destination
+            unsigned swap_destination_,
             /// [in] Swap Request Tag, Memory modules must Acknowledge with the same Tag
             unsigned swap_tag_,
             /// [in] see \ref type
@@ -76,52 +73,58 @@ class packet
             uint64_t address_ = 0,
             /// [in] see \ref bytes_accessed
             unsigned bytes_accessed_ = 4,
-            /// [in] see \ref cooldown and component class
-            unsigned cooldown_ = 0,
-            /// [in] see \ref name
-            const std::string& name_ = "Unnamed Packet"
+            /// [in] see \ref issued_at
+            unsigned long issued_at_ = 0
         );
         
-        /// The component which generated this packet
-        component* original_source;
-        
-        /// The component which this packet should be routed to
-        component* final_destination;
-        
-        /// Swap Destination
-        component* swap_destination;
-
-        /// Swap Tag
-        unsigned swap_tag;
-
-        /// Distinguishes between read requests, read responses,
-        /// write requests, etc
-        packetType type;
-        
-        /// A human readable name which is displayed upon calls to
-        /// component::print()
-        std::string name;
+        /// Packets are allocated from a pool of fixed-size slots rather
+        /// than the general heap, since one is created for almost every
+        /// simulated memory access.  Each thread keeps its own free list,
+        /// and a packet may be deleted on a different thread from the one
+        /// which created it, in which case the slot goes back to the
+        /// creating thread's pool.  Slots are never moved, so a packet
+        /// keeps the same address for its whole lifetime.
+        static void* operator new(std::size_t size);
         
-        /// The number of bytes associated with this memory transfer.
-        unsigned packet_size;
+        /// Return a packet's slot to the pool it was allocated from
+        static void operator delete(void* p, std::size_t size);
         
         /// If this packet is a memory operation such as a read/write request
         /// then this is the address of the first byte to be read/written.
-        /// If this is a multi-byte memory transaction, then bytes stored
-        /// in higher indexes within packet::data use the corresponding
-        /// address offsets: data[0] = address, data[1] = address + 1,
-        /// data[n] = address + n...
         uint64_t address;
         
+        /// Simulated time (see system_driver::get_time) at which the
+        /// request this packet belongs to was issued.  Packets made in
+        /// response to another packet inherit its issue time.
+        unsigned long issued_at;
+        
+        /// Swap Tag.  Read requests from an out-of-order \ref cpu carry a
+        /// tag of their own instead, which the response brings back.
+        unsigned swap_tag;
+        
         /// This is the number of bytes transferred whenever this packet
         /// migrates.  Typically this is a value such as 64 when a cache line
         /// is read or 256 for a DRAM burst read.
         unsigned bytes_accessed;
         
-        /// Managed by a component.  This is how long a packet must wait
-        /// before it can have another operation performed on it (such as
-        /// routing or retirement).
-        unsigned cooldown;
+        /// The component which generated this packet.  Packets refer to
+        /// components by their index in the owning \ref system_driver
+        /// (see system_driver::get_component) to keep packets small.
+        uint16_t original_source;
+        
+        /// The component which this packet should be routed to
+        uint16_t final_destination;
+        
+        /// Swap Destination, or \ref NO_COMPONENT
+        uint16_t swap_destination;
+        
+        /// Distinguishes between read requests, read responses,
+        /// write requests, etc
+        packetType type;
+        
+        /// Stored in packet::swap_destination when there is none.  Also
+        /// the limit on the number of components in one system.
+        static const uint16_t NO_COMPONENT = UINT16_MAX;
         
 };
 
@@ -0,0 +1,107 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              profile.h \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#ifndef __HEADER_GUARD_PROFILE__
+#define __HEADER_GUARD_PROFILE__
+
+#include <cstdint>
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#else
+    #include <chrono>
+#endif
+
+// 1 = count the calls to, and the CPU cycles spent in, each phase of the
+//     simulation for every component, and print a summary at the end of
+//     system_driver::simulate().  Build with -DPROFILE=1
+// else = no overhead
+#ifndef PROFILE
+    #define PROFILE 0
+#endif
+
+/// The parts of the simulation which are profiled
+enum profile_phase
+{
+    /// component::generate
+    PROFILE_GENERATE,
+    /// component::wake_packets
+    PROFILE_WAKE,
+    /// component::port_in, counted against the component receiving
+    PROFILE_PORT_IN,
+    /// component::retire
+    PROFILE_RETIRE,
+    NUM_PROFILE_PHASES
+};
+
+/// Profile of one component
+struct profile_counters
+{
+    /// Number of times each phase ran
+    unsigned long calls[NUM_PROFILE_PHASES];
+
+    /// CPU cycles spent in each phase, including any other phases which
+    /// ran inside it (a wake includes the retires and port_ins it caused)
+    uint64_t cycles[NUM_PROFILE_PHASES];
+
+    /// Calls to port_in() which turned the packet away, see
+    /// component::port_in.  Lots of these mean packets are spinning on a
+    /// busy component.
+    unsigned long port_in_rejected;
+};
+
+/// \return A cheap, monotonic cycle count
+inline uint64_t profile_clock()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+/// Adds the time between its construction and destruction to a phase of
+/// a profile.  Use through the profile() macro so it compiles away when
+/// PROFILE is off.
+class profile_scope
+{
+
+    public:
+
+        inline profile_scope(profile_counters& counters_, profile_phase phase_)
+            : counters(counters_), phase(phase_), start(profile_clock())
+        {
+        }
+
+        inline ~profile_scope()
+        {
+            this->counters.calls[this->phase]++;
+            this->counters.cycles[this->phase] += profile_clock() - this->start;
+        }
+
+    protected:
+
+        profile_counters& counters;
+        profile_phase phase;
+        uint64_t start;
+
+};
+
+#if PROFILE == 1
+    /// Profile the rest of the enclosing scope
+    #define profile(counters, phase) profile_scope profile_scope_(counters, phase)
+#else
+    #define profile(counters, phase) {}
+#endif
+
+#endif // header guard
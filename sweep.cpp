@@ -0,0 +1,277 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              sweep.cpp \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+// Parameter sweep over the migration controller settings.  Every
+// combination of the listed values is simulated, several at a time, and
+// the results are printed as one table.  Each trace is parsed once and
+// shared by all of the simulations.  A configuration which cannot be
+// built, or whose routes fail system_driver::check_routes, shows "failed"
+// in place of its total_time, and sweep then exits with an error.
+//
+// Usage:
+//     sweep [-c cpus] [-j threads] [-p page sizes] [-e epoch lengths]
+//           [-t cost thresholds] [-d diff thresholds] [-l link lanes]
+//           [-r reorder buffer sizes] [-k L1 cache sizes in KiB]
+//           [-b DRAM banks] [-s DRAM schedulers] [-v HMC vaults] trace...
+//
+// Lists are comma separated, for example -e 500,1000,2000.  Anything not
+// given keeps the value used by the main*.cpp program for that number of
+// CPUs.  Link lanes of 0 connect the components ideally, anything else
+// puts HMC links between them (see topology_config::link_lanes).
+// Reorder buffer sizes of 0 keep the simple CPU model, anything else
+// gives every CPU an out-of-order core (see topology_config::core_rob_size).
+// L1 cache sizes of 0 leave the CPUs without caches, anything else gives
+// each one a private L1 of that size (see topology_config::l1_size).
+// DRAM banks of 0 keep one row buffer per memory module, anything else
+// splits every module into that many banks (see
+// topology_config::dram_banks).  DRAM schedulers of 0 serve each bank's
+// requests FR-FCFS, 1 in the order they arrive (see
+// topology_config::dram_fcfs).  HMC vaults of 0 keep plain memory
+// modules, anything else makes every module an hmc_cube with that many
+// vaults (see topology_config::hmc_vaults).
+// There must be one trace per CPU.  A trace given as synthetic:<pattern>,
+// for example synthetic:zipf, gives that CPU a synthetic_cpu making up
+// accesses with default_synthetic(pattern) instead, seeded by its
+// position.  Either every CPU reads a trace or every CPU is synthetic.
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "synthetic_cpu.h"
+#include "system_driver.h"
+#include "topology.h"
+#include "trace.h"
+
+using namespace std;
+
+// Parse a comma separated list of numbers
+static bool parse_list(const char* text, vector<unsigned>& values)
+{
+	values.clear();
+	stringstream ss(text);
+	string item;
+	while (getline(ss, item, ','))
+	{
+		char* end;
+		unsigned long value = strtoul(item.c_str(), &end, 0);
+		if (item.empty() || *end != '\0')
+			return false;
+		values.push_back(value);
+	}
+	return !values.empty();
+}
+
+int main(int argc, char** argv)
+{
+
+	unsigned num_cpus = 1;
+	unsigned num_threads = thread::hardware_concurrency();
+	vector<unsigned> page_sizes, epoch_lengths, cost_thresholds, diff_thresholds, link_lanes, rob_sizes, l1_sizes, dram_banks, dram_fcfs, hmc_vaults;
+	vector<string> trace_files;
+
+	for (int ix = 1; ix < argc; ix++)
+	{
+		string arg = argv[ix];
+		if (arg.size() == 2 && arg[0] == '-' && ix + 1 < argc)
+		{
+			vector<unsigned> values;
+			if (!parse_list(argv[++ix], values))
+			{
+				cerr << "Error. Bad value '" << argv[ix] << "' for " << arg << endl;
+				return -1;
+			}
+			switch (arg[1])
+			{
+				case 'c': num_cpus = values[0]; break;
+				case 'j': num_threads = values[0]; break;
+				case 'p': page_sizes = values; break;
+				case 'e': epoch_lengths = values; break;
+				case 't': cost_thresholds = values; break;
+				case 'd': diff_thresholds = values; break;
+				case 'l': link_lanes = values; break;
+				case 'r': rob_sizes = values; break;
+				case 'k': l1_sizes = values; break;
+				case 'b': dram_banks = values; break;
+				case 's': dram_fcfs = values; break;
+				case 'v': hmc_vaults = values; break;
+				default:
+					cerr << "Error. Unknown option " << arg << endl;
+					return -1;
+			}
+		}
+		else
+		{
+			trace_files.push_back(arg);
+		}
+	}
+
+	if (trace_files.size() != num_cpus)
+	{
+		cerr
+			<< "Error. Please specify one trace per CPU\n"
+			<< "Usage: " << argv[0]
+			<< " [-c cpus] [-j threads] [-p page sizes] [-e epoch lengths]"
+			<< " [-t cost thresholds] [-d diff thresholds] [-l link lanes]"
+			<< " [-r reorder buffer sizes] [-k L1 cache sizes in KiB]"
+			<< " [-b DRAM banks] [-s DRAM schedulers] [-v HMC vaults] trace..."
+			<< endl;
+		return -1;
+	}
+	if (num_threads == 0)
+		num_threads = 1;
+
+	// Anything not swept keeps its default
+	topology_config defaults = default_topology(num_cpus);
+	if (page_sizes.empty()) page_sizes.push_back(defaults.page_size);
+	if (epoch_lengths.empty()) epoch_lengths.push_back(defaults.epoch_length);
+	if (cost_thresholds.empty()) cost_thresholds.push_back(defaults.cost_threshold);
+	if (diff_thresholds.empty()) diff_thresholds.push_back(defaults.diff_threshold);
+	if (link_lanes.empty()) link_lanes.push_back(defaults.link_lanes);
+	if (rob_sizes.empty()) rob_sizes.push_back(defaults.core_rob_size);
+	if (l1_sizes.empty()) l1_sizes.push_back(defaults.l1_size / 1024);
+	if (dram_banks.empty()) dram_banks.push_back(defaults.dram_banks);
+	if (dram_fcfs.empty()) dram_fcfs.push_back(defaults.dram_fcfs);
+	if (hmc_vaults.empty()) hmc_vaults.push_back(defaults.hmc_vaults);
+
+	// Parse each trace once, even if several CPUs read the same file
+	const string synthetic_prefix = "synthetic:";
+	map<string, trace> parsed;
+	vector<const trace*> traces;
+	vector<synthetic_config> workloads;
+	for (unsigned ix = 0; ix < trace_files.size(); ix++)
+	{
+		if (trace_files[ix].compare(0, synthetic_prefix.size(), synthetic_prefix) == 0)
+		{
+			synthetic_pattern pattern;
+			if (!parse_synthetic_pattern(trace_files[ix].substr(synthetic_prefix.size()), pattern))
+			{
+				cerr << "Error. Unknown synthetic pattern in " << trace_files[ix] << endl;
+				return -1;
+			}
+			workloads.push_back(default_synthetic(pattern));
+			workloads.back().seed = ix + 1;
+			continue;
+		}
+		if (parsed.count(trace_files[ix]) == 0 && !parsed[trace_files[ix]].load(trace_files[ix]))
+			return -1;
+		traces.push_back(&parsed[trace_files[ix]]);
+	}
+	if (!traces.empty() && !workloads.empty())
+	{
+		cerr << "Error. Either every CPU reads a trace or every CPU is synthetic" << endl;
+		return -1;
+	}
+
+	vector<topology_config> configs;
+	for (unsigned p = 0; p < page_sizes.size(); p++)
+	for (unsigned e = 0; e < epoch_lengths.size(); e++)
+	for (unsigned t = 0; t < cost_thresholds.size(); t++)
+	for (unsigned d = 0; d < diff_thresholds.size(); d++)
+	for (unsigned l = 0; l < link_lanes.size(); l++)
+	for (unsigned r = 0; r < rob_sizes.size(); r++)
+	for (unsigned k = 0; k < l1_sizes.size(); k++)
+	for (unsigned b = 0; b < dram_banks.size(); b++)
+	for (unsigned s = 0; s < dram_fcfs.size(); s++)
+	for (unsigned v = 0; v < hmc_vaults.size(); v++)
+	{
+		topology_config config = defaults;
+		config.page_size = page_sizes[p];
+		config.epoch_length = epoch_lengths[e];
+		config.cost_threshold = cost_thresholds[t];
+		config.diff_threshold = diff_thresholds[d];
+		config.link_lanes = link_lanes[l];
+		config.core_rob_size = rob_sizes[r];
+		config.l1_size = l1_sizes[k] * 1024;
+		config.dram_banks = dram_banks[b];
+		config.dram_fcfs = dram_fcfs[s] != 0;
+		config.hmc_vaults = hmc_vaults[v];
+		configs.push_back(config);
+	}
+
+	// Each thread takes the next configuration nobody has started yet.
+	// failed is not a vector<bool>, whose elements share bytes
+	vector<unsigned long> total_times(configs.size(), 0);
+	vector<unsigned char> failed(configs.size(), 0);
+	atomic<unsigned> next_config(0);
+	auto worker = [&]()
+	{
+		unsigned ix;
+		while ((ix = next_config.fetch_add(1)) < configs.size())
+		{
+			system_driver* motherboard = workloads.empty()
+				? build_topology(configs[ix], traces)
+				: build_topology(configs[ix], workloads);
+			if (motherboard == NULL)
+			{
+				failed[ix] = 1;
+				continue;
+			}
+			if (!motherboard->check_routes())
+			{
+				failed[ix] = 1;
+				delete motherboard;
+				continue;
+			}
+			motherboard->set_output(NULL);
+			motherboard->simulate();
+			// get_time() leaves out the UINT_MAX simulate() adds at quiescence
+			total_times[ix] = motherboard->get_time();
+			delete motherboard;
+		}
+	};
+	if (num_threads > configs.size())
+		num_threads = configs.size();
+	vector<thread> pool;
+	for (unsigned ix = 1; ix < num_threads; ix++)
+		pool.push_back(thread(worker));
+	worker();
+	for (unsigned ix = 0; ix < pool.size(); ix++)
+		pool[ix].join();
+
+	unsigned num_failed = 0;
+	cout << "cpus\tpage_size\tepoch_length\tcost_threshold\tdiff_threshold\tlink_lanes\trob_size\tl1_kib\tdram_banks\tdram_fcfs\thmc_vaults\ttotal_time" << endl;
+	for (unsigned ix = 0; ix < configs.size(); ix++)
+	{
+		cout
+			<< configs[ix].num_cpus << '\t'
+			<< configs[ix].page_size << '\t'
+			<< configs[ix].epoch_length << '\t'
+			<< configs[ix].cost_threshold << '\t'
+			<< configs[ix].diff_threshold << '\t'
+			<< configs[ix].link_lanes << '\t'
+			<< configs[ix].core_rob_size << '\t'
+			<< configs[ix].l1_size / 1024 << '\t'
+			<< configs[ix].dram_banks << '\t'
+			<< configs[ix].dram_fcfs << '\t'
+			<< configs[ix].hmc_vaults << '\t';
+		if (failed[ix])
+		{
+			cout << "failed" << endl;
+			num_failed++;
+		}
+		else
+			cout << total_times[ix] << endl;
+	}
+
+	if (num_failed > 0)
+	{
+		cerr << "Error. " << num_failed << " of " << configs.size() << " configurations failed" << endl;
+		return -1;
+	}
+	return 0;
+
+}
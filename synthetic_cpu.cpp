@@ -0,0 +1,224 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              synthetic_cpu.cpp \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#include <cmath>
+#include "checkpoint.h"
+#include "debug.h"
+#include "synthetic_cpu.h"
+
+// Names of the patterns, in the order of synthetic_pattern
+static const char* const pattern_names[] =
+{
+    "sequential",
+    "uniform",
+    "zipf",
+    "phased",
+    "producer",
+    "consumer"
+};
+static const unsigned num_patterns = sizeof(pattern_names) / sizeof(pattern_names[0]);
+
+// Terms of the Zipf normalization summed exactly, the rest are
+// approximated by an integral
+static const uint64_t zeta_terms = 1000000;
+
+// Sum of 1 / i^theta for i from 1 to n
+static double zeta(uint64_t n, double theta)
+{
+    double sum = 0.0;
+    uint64_t exact = n < zeta_terms ? n : zeta_terms;
+    for (uint64_t i = 1; i <= exact; i++)
+        sum += 1.0 / std::pow((double)i, theta);
+    if (n > exact)
+        sum += (std::pow((double)n, 1.0 - theta) - std::pow((double)exact, 1.0 - theta)) / (1.0 - theta);
+    return sum;
+}
+
+synthetic_config default_synthetic(synthetic_pattern pattern)
+{
+    synthetic_config config;
+    config.pattern = pattern;
+    config.base = 0;
+    config.footprint = 64 << 20;
+    config.stride = 64;
+    config.zipf_theta = 0.99;
+    config.write_fraction = 0.3;
+    config.interval = 0;
+    config.num_accesses = 200000;
+    config.phase_length = 50000;
+    config.phase_shift = config.footprint / 4;
+    config.seed = 1;
+    return config;
+}
+
+bool parse_synthetic_pattern(const std::string& name, synthetic_pattern& pattern)
+{
+    for (unsigned ix = 0; ix < num_patterns; ix++)
+    {
+        if (name == pattern_names[ix])
+        {
+            pattern = (synthetic_pattern)ix;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* synthetic_pattern_name(synthetic_pattern pattern)
+{
+    return (unsigned)pattern < num_patterns ? pattern_names[pattern] : "unknown";
+}
+
+synthetic_cpu::synthetic_cpu
+(
+    const synthetic_config& config_,
+    const std::string& name_,
+    unsigned max_Operations_,
+    unsigned initiation_interval_,
+    unsigned max_resident_packets_,
+    unsigned routing_latency_,
+    unsigned retirement_latency_
+) : cpu
+(
+    name_,
+    max_Operations_,
+    initiation_interval_,
+    max_resident_packets_,
+    routing_latency_,
+    retirement_latency_
+){
+
+    check(config_.stride > 0, "A synthetic CPU needs a stride of at least 1 byte");
+    check(config_.footprint >= config_.stride, "A synthetic CPU's footprint must hold at least one stride");
+    check(config_.zipf_theta > 0.0 && config_.zipf_theta < 1.0, "zipf_theta must be between 0 and 1");
+    check((unsigned)config_.pattern < num_patterns, "Unknown synthetic pattern");
+    this->config = config_;
+    this->slots = config_.footprint / config_.stride;
+    this->generated = 0;
+    // xorshift never leaves 0, so a seed of 0 is moved
+    this->rng = config_.seed != 0 ? config_.seed : 0x9E3779B97F4A7C15ull;
+
+    this->zeta_n = 1.0;
+    this->zipf_alpha = 1.0;
+    this->zipf_eta = 0.0;
+    if ((config_.pattern == ZIPF || config_.pattern == PHASED) && this->slots > 1)
+    {
+        double theta = config_.zipf_theta;
+        this->zeta_n = zeta(this->slots, theta);
+        this->zipf_alpha = 1.0 / (1.0 - theta);
+        this->zipf_eta =
+            (1.0 - std::pow(2.0 / this->slots, 1.0 - theta))
+          / (1.0 - zeta(2, theta) / this->zeta_n);
+    }
+
+}
+
+bool synthetic_cpu::trace_ended() const
+{
+    return this->generated >= this->config.num_accesses;
+}
+
+bool synthetic_cpu::read_record(trace_record& record)
+{
+
+    if (this->trace_ended())
+        return false;
+
+    uint64_t slot;
+    char rw = 'R';
+    switch (this->config.pattern)
+    {
+        case SEQUENTIAL:
+            slot = this->generated;
+            break;
+        case UNIFORM:
+            slot = this->next_random() % this->slots;
+            break;
+        case ZIPF:
+            slot = this->next_zipf();
+            break;
+        case PHASED:
+            slot = this->next_zipf()
+                + (this->generated / this->config.phase_length) * (this->config.phase_shift / this->config.stride);
+            break;
+        case PRODUCER:
+            slot = this->generated;
+            rw = 'W';
+            break;
+        default:
+            slot = this->generated;
+            break;
+    }
+    if
+    (
+        this->config.pattern != PRODUCER &&
+        this->config.pattern != CONSUMER &&
+        this->next_unit() < this->config.write_fraction
+    )
+        rw = 'W';
+
+    record.address = this->slot_address(slot);
+    record.depends = 0;
+    record.gap = this->generated == 0 ? 0 : this->config.interval;
+    record.rw = rw;
+    this->generated++;
+    this->records_read++;
+    return true;
+
+}
+
+uint64_t synthetic_cpu::next_random()
+{
+    this->rng ^= this->rng >> 12;
+    this->rng ^= this->rng << 25;
+    this->rng ^= this->rng >> 27;
+    return this->rng * 0x2545F4914F6CDD1Dull;
+}
+
+double synthetic_cpu::next_unit()
+{
+    // the top 53 bits fill a double's mantissa exactly
+    return (this->next_random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+uint64_t synthetic_cpu::next_zipf()
+{
+
+    // Gray et al., "Quickly generating billion-record synthetic
+    // databases", as YCSB does it
+    if (this->slots <= 1)
+        return 0;
+    double u = this->next_unit();
+    double uz = u * this->zeta_n;
+    if (uz < 1.0)
+        return 0;
+    if (uz < 1.0 + std::pow(0.5, this->config.zipf_theta))
+        return 1;
+    uint64_t slot = (uint64_t)(this->slots * std::pow(this->zipf_eta * u - this->zipf_eta + 1.0, this->zipf_alpha));
+    return slot < this->slots ? slot : this->slots - 1;
+
+}
+
+void synthetic_cpu::save(std::ostream& out)
+{
+    cpu::save(out);
+    checkpoint_write(out, this->generated);
+    checkpoint_write(out, this->rng);
+}
+
+bool synthetic_cpu::restore(std::istream& in)
+{
+    return
+        cpu::restore(in) &&
+        checkpoint_read(in, this->generated) &&
+        checkpoint_read(in, this->rng);
+}
@@ -0,0 +1,188 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              synthetic_cpu.h \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#ifndef __HEADER_GUARD_SYNTHETIC_CPU__
+#define __HEADER_GUARD_SYNTHETIC_CPU__
+
+#include <cstdint>
+#include <string>
+#include "cpu.h"
+
+/// Which addresses a \ref synthetic_cpu accesses
+enum synthetic_pattern : uint8_t
+{
+    /// One slot after another through the footprint, wrapping around
+    SEQUENTIAL,
+    /// Any slot of the footprint with equal probability
+    UNIFORM,
+    /// Slots drawn from a Zipf distribution, so a small hot set near the
+    /// start of the footprint gets most of the accesses
+    ZIPF,
+    /// ZIPF, with the hot set moving further into the footprint every
+    /// synthetic_config::phase_length accesses
+    PHASED,
+    /// Writes one slot after another through the footprint, for
+    /// CONSUMER CPUs given the same footprint to read
+    PRODUCER,
+    /// Reads one slot after another through the footprint.  Nothing
+    /// holds a CONSUMER back until a PRODUCER has written a slot: the CPUs
+    /// do not look at each other, so results do not depend on the order
+    /// system_driver calls generate() in.
+    /// Give the PRODUCER the smaller synthetic_config::interval to keep
+    /// it ahead.
+    CONSUMER
+};
+
+/// Everything a \ref synthetic_cpu needs to make up its accesses
+struct synthetic_config
+{
+    /// See synthetic_pattern
+    synthetic_pattern pattern;
+
+    /// First address of the region accessed
+    uint64_t base;
+
+    /// Bytes in the region accessed, a multiple of stride
+    uint64_t footprint;
+
+    /// Bytes from one slot of the region to the next.  Every access is
+    /// to the start of a slot.
+    unsigned stride;
+
+    /// Skew of ZIPF and PHASED, between 0 and 1 exclusive.  The closer to
+    /// 1, the smaller the hot set.
+    double zipf_theta;
+
+    /// Fraction of the accesses which are writes, except for PRODUCER
+    /// (all writes) and CONSUMER (all reads)
+    double write_fraction;
+
+    /// Ticks from one access to the next at least, 0 for as fast as the
+    /// CPU can issue them.  Given to every access after the first as its
+    /// trace_record::gap.
+    unsigned interval;
+
+    /// Accesses made before the CPU stops, like the end of a trace
+    unsigned long num_accesses;
+
+    /// Accesses PHASED makes before moving its hot set
+    unsigned long phase_length;
+
+    /// Bytes PHASED moves its hot set by, wrapping around the footprint
+    uint64_t phase_shift;
+
+    /// Seed of the random number generator
+    uint64_t seed;
+};
+
+/// \return A configuration for pattern over the first 64 MiB of memory
+synthetic_config default_synthetic
+(
+    /// [in] See synthetic_config::pattern
+    synthetic_pattern pattern
+);
+
+/// Read a pattern name, as printed by synthetic_pattern_name()
+/// \return false if name is not a pattern
+bool parse_synthetic_pattern
+(
+    /// [in] For example "zipf"
+    const std::string& name,
+    /// [out] The pattern
+    synthetic_pattern& pattern
+);
+
+/// \return The name of pattern in lower case, for example "zipf"
+const char* synthetic_pattern_name(synthetic_pattern pattern);
+
+/// \class synthetic_cpu
+/// A \ref cpu which makes its accesses up as it goes instead of reading a
+/// trace, so the network and the migration controller can be loaded at
+/// any scale with no file to read.  Everything else, the simple and the
+/// out-of-order core model, the caches and checkpoints, works as it does
+/// for a CPU reading a trace.  The accesses only depend on the
+/// configuration, so a run can be repeated exactly.
+class synthetic_cpu : public cpu
+{
+
+    public:
+
+        synthetic_cpu
+        (
+            /// [in] See \ref synthetic_config
+            const synthetic_config& config_,
+            /// [in] See \ref component::name
+            const std::string& name_ = "Unnamed CPU",
+            /// [in] Maximum number of Loads allowed in flight
+            unsigned max_Operations_ = 4,
+            /// [in] See \ref component::initiation_interval
+            unsigned initiation_interval_ = 0,
+            /// [in] See \ref component::initiation_interval
+            unsigned max_resident_packets_ = 8,
+            /// [in] See \ref component::routing_latency
+            unsigned routing_latency_ = 0,
+            /// [in] See \ref component::retirement_latency
+            unsigned retirement_latency_ = 0
+        );
+
+        /// Also saves the position in the pattern and the state of the
+        /// random number generator.  See cpu::save
+        void save(std::ostream& out);
+
+        /// See cpu::restore
+        bool restore(std::istream& in);
+
+    protected:
+
+        /// Make up the next access
+        /// \return false once num_accesses have been made
+        bool read_record(trace_record& record);
+
+        /// \return true once num_accesses have been made
+        bool trace_ended() const;
+
+        /// \return The address of slot of the footprint
+        inline uint64_t slot_address(uint64_t slot) const
+        {
+            return this->config.base + (slot % this->slots) * this->config.stride;
+        }
+
+        /// \return The next output of the xorshift64* generator
+        uint64_t next_random();
+
+        /// \return A uniform random number in [0, 1)
+        double next_unit();
+
+        /// \return A slot drawn from the Zipf distribution over
+        /// synthetic_cpu::slots, 0 the most likely
+        uint64_t next_zipf();
+
+        /// See \ref synthetic_config
+        synthetic_config config;
+
+        /// Slots in the footprint
+        uint64_t slots;
+
+        /// Accesses made so far
+        unsigned long generated;
+
+        /// State of the random number generator, never 0
+        uint64_t rng;
+
+        /// Constants of the Zipf distribution, see next_zipf()
+        double zeta_n;
+        double zipf_alpha;
+        double zipf_eta;
+
+};
+
+#endif // header guard
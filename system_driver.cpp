@@ -11,11 +11,21 @@
 /// Target architecture:    x86_64 */
 
 #include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include "checkpoint.h"
 #include "component.h"
 #include "debug.h"
+#include "hmc_link.h"
+#include "packet.h"
 #include "system_driver.h"
 
+// first bytes of every checkpoint file
+static const char checkpoint_magic[8] = {'H', 'M', 'C', 'C', 'K', 'P', 'T', 'A'};
+
 system_driver::~system_driver()
 {
     // destroy and de-alocate all resident components.  Nothing weird here.
@@ -29,21 +39,359 @@ system_driver::~system_driver()
 void system_driver::add_component(component* c)
 {
     check(c != NULL, "Cannot add NULL component to system_driver");
+    check(c->driver == NULL, "Component was already added to a system_driver");
+    check(this->resident_components.size() < packet::NO_COMPONENT, "Too many components for packet::original_source");
+    c->driver = this;
+    c->id = this->resident_components.size();
     this->resident_components.push_back(c);
+    this->due_flags.push_back(false);
+    this->active_flags.push_back(false);
+    this->routes_checked = false;
+    c->refresh_wake();
+    if (c->next_wake != ULONG_MAX)
+        this->events.push({c->next_wake, c->id});
+}
+
+void system_driver::set_output(std::ostream* output_)
+{
+    this->output = output_;
 }
 
-// this function steps through each component's generate(),
-// advance_cooldowns(), and wake_packets() functions.  Quiescence occurs
-// when all components return UINT_MAX as their cooldown for all stages
-unsigned long system_driver::simulate()
+void system_driver::schedule(component* c)
+{
+    // A component later in the wake pass which just became due is woken
+    // in this same pass, just as if it had been swept in order.
+    // Everything else waits for the next pass.
+    if (this->waking && c->next_wake <= this->now && c->id > this->waking_id)
+    {
+        if (!this->due_flags[c->id])
+        {
+            this->due_flags[c->id] = true;
+            this->due.push(c->id);
+        }
+    }
+    else
+    {
+        this->events.push({c->next_wake, c->id});
+    }
+}
+
+unsigned long system_driver::retry_time(const component* c)
+{
+    // c is still to be swept in this pass, it would have retried now
+    if (this->waking && c->id > this->waking_id)
+        return this->now;
+    this->retry_cooldown = 1;
+    return this->now + 1;
+}
+
+void system_driver::activate(component* c)
+{
+    if (this->active_flags[c->id])
+        return;
+    this->active_flags[c->id] = true;
+    this->active.push_back(c->id);
+}
+
+bool system_driver::compile_routes()
 {
     
-    unsigned long elapsed_ticks = 0;
+    bool ok = true;
+    unsigned num_resident_components = this->resident_components.size();
+    for (unsigned ix = 0; ix < num_resident_components; ix++)
+    {
+        component* c = this->resident_components[ix];
+        c->next_hop.assign(num_resident_components, NULL);
+        for (auto it = c->routing_table.begin(); it != c->routing_table.end(); it++)
+        {
+            if (it->first->driver != this || it->second->driver != this)
+            {
+                std::cerr
+                    << "Error. \"" << c->name
+                    << "\" has a route which leads outside this system"
+                    << std::endl;
+                ok = false;
+                continue;
+            }
+            c->next_hop[it->first->id] = it->second;
+        }
+        
+        c->link_to.clear();
+        if (!c->links.empty())
+            c->link_to.assign(num_resident_components, NULL);
+        for (unsigned l = 0; l < c->links.size(); l++)
+        {
+            if (c->links[l]->destination->driver != this)
+            {
+                std::cerr
+                    << "Error. \"" << c->name
+                    << "\" has a link which leads outside this system"
+                    << std::endl;
+                ok = false;
+                continue;
+            }
+            c->link_to[c->links[l]->destination->id] = c->links[l];
+        }
+    }
+    
+    // every hop along a route must know the way on to the destination.
+    // Walk each route, but stop at the first problem so that one broken
+    // hop is only reported once per source
+    for (unsigned ix = 0; ix < num_resident_components; ix++)
+    {
+        component* source = this->resident_components[ix];
+        for (unsigned destination = 0; destination < num_resident_components; destination++)
+        {
+            if (source->next_hop[destination] == NULL)
+                continue;
+            component* at = source;
+            unsigned hops = 0;
+            while (at->id != destination)
+            {
+                component* next = at->next_hop[destination];
+                if (next == NULL || hops == num_resident_components)
+                {
+                    std::cerr
+                        << "Error. The route from \"" << source->name
+                        << "\" to \"" << this->resident_components[destination]->name
+                        << (next == NULL ? "\" has no next hop at \"" : "\" loops at \"")
+                        << at->name << '\"'
+                        << std::endl;
+                    ok = false;
+                    break;
+                }
+                at = next;
+                hops++;
+            }
+        }
+    }
+    
+    // the walk above only follows routes which exist, so ask the
+    // components which routes they cannot do without
+    std::vector<std::pair<const component*, const component*> > required;
+    for (unsigned ix = 0; ix < num_resident_components; ix++)
+        this->resident_components[ix]->required_routes(required);
+    for (unsigned r = 0; r < required.size(); r++)
+    {
+        const component* source = required[r].first;
+        const component* destination = required[r].second;
+        if (source->driver != this || destination->driver != this)
+        {
+            std::cerr
+                << "Error. \"" << source->name << "\" needs a route to \""
+                << destination->name << "\" but one of them is outside this system"
+                << std::endl;
+            ok = false;
+        }
+        else if (source != destination && source->next_hop[destination->id] == NULL)
+        {
+            std::cerr
+                << "Error. \"" << source->name
+                << "\" has no route to \"" << destination->name << '\"'
+                << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+    
+}
+
+bool system_driver::check_routes()
+{
+    
+    if (!this->routes_checked)
+    {
+        this->routes_valid = this->compile_routes();
+        this->routes_checked = true;
+    }
+    return this->routes_valid;
+    
+}
+
+void system_driver::discard_stale_events()
+{
+    while (!this->events.empty())
+    {
+        const wake_event& e = this->events.top();
+        if (e.time == this->resident_components[e.id]->next_wake)
+            break;
+        this->events.pop();
+    }
+}
+
+unsigned long system_driver::simulate(unsigned long stop_ticks)
+{
+    
+    if (!this->check_routes())
+    {
+        std::cerr << "Error. Refusing to simulate a system with broken routes" << std::endl;
+        return this->elapsed_ticks;
+    }
+    if (this->run(stop_ticks) == UINT_MAX && this->output != NULL)
+        *this->output << "Total Time = " << this->elapsed_ticks << std::endl;
+    if (this->output != NULL)
+    {
+        this->print_links(this->output);
+        for (unsigned ix = 0; ix < this->resident_components.size(); ix++)
+            this->resident_components[ix]->print_stats(this->output);
+    }
+    if (PROFILE && this->output != NULL)
+        this->print_profile(this->output);
+    return this->elapsed_ticks;
+    
+}
+
+unsigned long system_driver::simulate_sampled
+(
+    unsigned long detailed_ticks,
+    unsigned long functional_ticks
+){
+    
+    check(detailed_ticks > 0, "Sampled simulation needs detailed windows of at least one tick");
+    if (!this->check_routes())
+    {
+        std::cerr << "Error. Refusing to simulate a system with broken routes" << std::endl;
+        return this->elapsed_ticks;
+    }
+    
+    // the clock is moved this far at a time while fast-forwarding, so that
+    // epochs still end close to where they would have
+    const unsigned long fast_forward_chunk = 1000;
+    
+    unsigned num_resident_components = this->resident_components.size();
+    std::vector<unsigned long> records_before(num_resident_components);
+    std::vector<double> records_per_tick(num_resident_components);
+    std::vector<double> records_owed(num_resident_components);
+    double rate_sum = 0.0;
+    double rate_sum_squares = 0.0;
+    unsigned long num_samples = 0;
+    unsigned long functional_records = 0;
+    
+    while (true)
+    {
+        
+        // detailed window
+        unsigned long ticks_before = this->elapsed_ticks;
+        unsigned long window_records = 0;
+        for (unsigned ix = 0; ix < num_resident_components; ix++)
+            records_before[ix] = this->resident_components[ix]->get_records_read();
+        if (this->run(ticks_before + detailed_ticks) == UINT_MAX)
+            break;
+        
+        double window_ticks = (double)(this->elapsed_ticks - ticks_before);
+        for (unsigned ix = 0; ix < num_resident_components; ix++)
+        {
+            unsigned long num_read = this->resident_components[ix]->get_records_read() - records_before[ix];
+            records_per_tick[ix] = (double)num_read / window_ticks;
+            records_owed[ix] = 0.0;
+            window_records += num_read;
+        }
+        
+        // a window which read nothing (the traces are done and the last
+        // packets are draining) says nothing about the trace
+        if (window_records == 0)
+            continue;
+        double rate = window_ticks / (double)window_records;
+        rate_sum += rate;
+        rate_sum_squares += rate * rate;
+        num_samples++;
+        
+        // functional fast-forward: every component reads the trace at the
+        // rate it managed in the window, only warming the migration tables
+        // and row buffers
+        for (unsigned long skipped = 0; skipped < functional_ticks; )
+        {
+            unsigned long chunk = functional_ticks - skipped;
+            if (chunk > fast_forward_chunk)
+                chunk = fast_forward_chunk;
+            unsigned long chunk_records = 0;
+            for (unsigned ix = 0; ix < num_resident_components; ix++)
+            {
+                records_owed[ix] += records_per_tick[ix] * (double)chunk;
+                unsigned long num_records = (unsigned long)records_owed[ix];
+                if (num_records == 0)
+                    continue;
+                records_owed[ix] -= (double)num_records;
+                chunk_records += this->resident_components[ix]->fast_forward(num_records);
+            }
+            
+            // every trace ran out, the rest is simulated in detail
+            if (chunk_records == 0)
+                break;
+            functional_records += chunk_records;
+            this->now += chunk;
+            this->elapsed_ticks += chunk;
+            skipped += chunk;
+        }
+        
+    }
+    this->resume_after_quiescence();
+    
+    // 95% confidence interval on the time charged to fast-forwarded records
+    double error = 0.0;
+    if (num_samples > 1)
+    {
+        double mean_rate = rate_sum / (double)num_samples;
+        double variance = (rate_sum_squares - num_samples * mean_rate * mean_rate) / (double)(num_samples - 1);
+        if (variance < 0.0)
+            variance = 0.0;
+        error = 1.96 * sqrt(variance / (double)num_samples) * (double)functional_records;
+    }
+    
+    if (this->output != NULL)
+    {
+        *this->output
+            << "Sampled Total Time = " << this->elapsed_ticks
+            << " (+/- " << (unsigned long)(error + 0.5)
+            << " at 95% confidence, " << num_samples << " samples)"
+            << std::endl;
+    }
+    return this->elapsed_ticks;
+    
+}
+
+void system_driver::resume_after_quiescence()
+{
+    // the step which found quiescence counted UINT_MAX ticks which never
+    // happened
+    if (this->advancement_amount == UINT_MAX)
+    {
+        this->elapsed_ticks -= UINT_MAX;
+        this->advancement_amount = 0;
+    }
+}
+
+// Each iteration calls generate() on the active components, moves the clock
+// forward, then wakes only the components which have a packet whose
+// cooldown has expired.  The amount to move the clock on the next
+// iteration is the same as if every component had been swept: the
+// minimum of what generate() and wake_packets() returned and of the
+// cooldowns still pending when the pass started.  Quiescence occurs when
+// that minimum is UINT_MAX.
+//
+// The whole loop runs on the calling thread.  A conservative parallel
+// scheme needs lookahead between partitions, but port_in() accepts or
+// refuses a packet the moment it is offered and CPUs route with no
+// latency, so the lookahead on every bundled topology is zero.  Running
+// only generate() in parallel keeps the result, but needs a barrier on
+// every step which costs more than the generate() calls it spreads out.
+unsigned system_driver::run(unsigned long stop_ticks)
+{
     
     unsigned advancement_accumulator;
-    unsigned advancement_amount = 0;
     unsigned num_resident_components = this->resident_components.size();
-    unsigned iteration = 1;
+    
+    this->resume_after_quiescence();
+    
+    // start with every component which has asked for generate()
+    this->active.clear();
+    for (unsigned ix = 0; ix < num_resident_components; ix++)
+    {
+        this->active_flags[ix] = this->resident_components[ix]->generate_at != ULONG_MAX;
+        if (this->active_flags[ix])
+            this->active.push_back(ix);
+    }
+    
 	do
 	{
 
@@ -53,12 +401,12 @@ unsigned long system_driver::simulate()
 			std::cout
 				<< std::endl << std::endl
 				<< "### Iteration "
-				<< iteration
+				<< this->iteration
 				<< "   Elapsed Time "
-				<< elapsed_ticks
+				<< this->elapsed_ticks
 				<< " ###"
 				<< std::endl;
-			iteration++;
+			this->iteration++;
 			for (unsigned ix = 0; ix < num_resident_components; ix++)
 			{
 				this->resident_components[ix]->print();
@@ -66,40 +414,295 @@ unsigned long system_driver::simulate()
 		}
         
         // generate...
-        for (unsigned ix = 0; ix < num_resident_components; ix++)
+        unsigned long min_deadline = ULONG_MAX;
+        for (unsigned ix = 0; ix < this->active.size(); )
         {
-            unsigned cur_cooldown = this->resident_components[ix]->generate();
+            component* c = this->resident_components[this->active[ix]];
+            if (c->generate_at > this->now)
+            {
+                if (c->generate_deadline < min_deadline)
+                    min_deadline = c->generate_deadline;
+                ix++;
+                continue;
+            }
+            
+            // generate() asks again if it wants to be called in future
+            c->generate_at = ULONG_MAX;
+            c->generate_deadline = ULONG_MAX;
+            unsigned num_packets = c->resident_packets.size();
+            unsigned cur_cooldown;
+            {
+                profile(c->profile_data, PROFILE_GENERATE);
+                cur_cooldown = c->generate();
+            }
             if (cur_cooldown < advancement_accumulator)
                 advancement_accumulator = cur_cooldown;
+            if (c->resident_packets.size() != num_packets)
+            {
+                c->refresh_wake();
+                if (c->next_wake != ULONG_MAX)
+                    this->events.push({c->next_wake, c->id});
+            }
 			if (DEBUG) std::cout << "generate() Cooldown = " << cur_cooldown << std::endl;
+            
+            // leave the active set until a packet arrives or leaves
+            if (c->generate_at == ULONG_MAX)
+            {
+                this->active_flags[c->id] = false;
+                this->active[ix] = this->active.back();
+                this->active.pop_back();
+            }
+            else
+            {
+                if (c->generate_deadline < min_deadline)
+                    min_deadline = c->generate_deadline;
+                ix++;
+            }
         }
         
         // advance cooldowns...
-        for (unsigned ix = 0; ix < num_resident_components; ix++)
+        // only the clock moves, packets and components keep absolute
+        // wake times
+        this->now += this->advancement_amount;
+        this->discard_stale_events();
+        if (!this->events.empty())
         {
-            unsigned cur_cooldown = this->resident_components[ix]->advance_cooldowns(advancement_amount);
+            unsigned long next = this->events.top().time;
+            unsigned cur_cooldown = next <= this->now ? 0 : (unsigned)(next - this->now);
             if (cur_cooldown < advancement_accumulator)
                 advancement_accumulator = cur_cooldown;
-			if (DEBUG) std::cout << "advance_cooldowns() Cooldown = " << cur_cooldown << std::endl;
+			if (DEBUG) std::cout << "Next Wake Cooldown = " << cur_cooldown << std::endl;
+        }
+        
+        // collect every component which is due...
+        while (!this->events.empty() && this->events.top().time <= this->now)
+        {
+            wake_event e = this->events.top();
+            this->events.pop();
+            if (e.time != this->resident_components[e.id]->next_wake)
+                continue;
+            if (!this->due_flags[e.id])
+            {
+                this->due_flags[e.id] = true;
+                this->due.push(e.id);
+            }
         }
         
         // wake packets...
-        for (unsigned ix = 0; ix < num_resident_components; ix++)
+        this->waking = true;
+        this->retry_cooldown = UINT_MAX;
+        while (!this->due.empty())
         {
-            unsigned cur_cooldown = this->resident_components[ix]->wake_packets();
+            unsigned ix = this->due.top();
+            this->due.pop();
+            this->waking_id = ix;
+            
+            component* c = this->resident_components[ix];
+            unsigned cur_cooldown;
+            {
+                profile(c->profile_data, PROFILE_WAKE);
+                cur_cooldown = c->wake_packets();
+            }
             if (cur_cooldown < advancement_accumulator)
                 advancement_accumulator = cur_cooldown;
 			if (DEBUG) std::cout << "wake_packets() Cooldown = " << cur_cooldown << std::endl;
+            
+            // wake_packets() brought component::next_wake up to date
+            this->due_flags[ix] = false;
+            if (c->next_wake != ULONG_MAX)
+                this->events.push({c->next_wake, c->id});
         }
+        this->waking = false;
+        if (this->retry_cooldown < advancement_accumulator)
+            advancement_accumulator = this->retry_cooldown;
         
-        advancement_amount = advancement_accumulator;
-        elapsed_ticks += (unsigned long)advancement_accumulator;
+        // ...and stop the clock where a component asked for a timed
+        // generate()
+        if (min_deadline != ULONG_MAX)
+        {
+            unsigned cur_cooldown = min_deadline <= this->now ? 0 : (unsigned)(min_deadline - this->now);
+            if (cur_cooldown < advancement_accumulator)
+                advancement_accumulator = cur_cooldown;
+        }
         
-    } while (advancement_accumulator != UINT_MAX);
+        this->advancement_amount = advancement_accumulator;
+        this->elapsed_ticks += (unsigned long)advancement_accumulator;
+        
+    } while (advancement_accumulator != UINT_MAX && this->elapsed_ticks < stop_ticks);
+    
+    return advancement_accumulator;
+    
+}
+
+bool system_driver::save_checkpoint(const std::string& filename)
+{
+    
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    if (!out.good())
+    {
+        std::cerr << "Error. Failed to open " << filename << " for writing" << std::endl;
+        return false;
+    }
+    
+    out.write(checkpoint_magic, sizeof(checkpoint_magic));
+    uint32_t num_resident_components = this->resident_components.size();
+    checkpoint_write(out, num_resident_components);
+    checkpoint_write(out, this->now);
+    checkpoint_write(out, this->elapsed_ticks);
+    checkpoint_write(out, this->advancement_amount);
+    checkpoint_write(out, this->iteration);
+    
+    for (unsigned ix = 0; ix < num_resident_components; ix++)
+        this->resident_components[ix]->save(out);
+    
+    if (!out.good())
+    {
+        std::cerr << "Error. Failed to write checkpoint " << filename << std::endl;
+        return false;
+    }
+    return true;
+    
+}
+
+bool system_driver::restore_checkpoint(const std::string& filename)
+{
+    
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in.good())
+    {
+        std::cerr << "Error. Failed to open " << filename << " for reading" << std::endl;
+        return false;
+    }
+    
+    char magic[sizeof(checkpoint_magic)];
+    uint32_t num_saved_components;
+    in.read(magic, sizeof(magic));
+    if
+    (
+        !in.good() ||
+        memcmp(magic, checkpoint_magic, sizeof(magic)) != 0 ||
+        !checkpoint_read(in, num_saved_components) ||
+        num_saved_components != this->resident_components.size()
+    )
+    {
+        std::cerr << "Error. " << filename << " is not a checkpoint of this system" << std::endl;
+        return false;
+    }
+    
+    if
+    (
+        !checkpoint_read(in, this->now) ||
+        !checkpoint_read(in, this->elapsed_ticks) ||
+        !checkpoint_read(in, this->advancement_amount) ||
+        !checkpoint_read(in, this->iteration)
+    )
+    {
+        std::cerr << "Error. Checkpoint " << filename << " is truncated" << std::endl;
+        return false;
+    }
+    
+    // components rebuild their own wake times, the event queue is rebuilt
+    // from those
+    this->events = decltype(this->events)();
+    for (unsigned ix = 0; ix < num_saved_components; ix++)
+    {
+        component* c = this->resident_components[ix];
+        if (!c->restore(in))
+        {
+            std::cerr << "Error. Failed to restore " << c->name << " from " << filename << std::endl;
+            return false;
+        }
+        if (c->next_wake != ULONG_MAX)
+            this->events.push({c->next_wake, c->id});
+    }
     
-	std::cout << "Total Time = " << elapsed_ticks << std::endl;
-    return elapsed_ticks;
+    return true;
     
 }
 
+unsigned long system_driver::get_packets_destroyed() const
+{
+    unsigned long total = 0;
+    for (unsigned ix = 0; ix < this->resident_components.size(); ix++)
+        total += this->resident_components[ix]->get_packets_destroyed();
+    return total;
+}
+
+void system_driver::print_links(std::ostream* file) const
+{
+    
+    bool header = false;
+    unsigned num_resident_components = this->resident_components.size();
+    for (unsigned ix = 0; ix < num_resident_components; ix++)
+    {
+        const component* c = this->resident_components[ix];
+        for (unsigned l = 0; l < c->links.size(); l++)
+        {
+            if (!header)
+            {
+                *file
+                    << std::endl << std::left
+                    << std::setw(30) << "link from"
+                    << std::setw(30) << "to"
+                    << std::right
+                    << std::setw(12) << "packets"
+                    << std::setw(12) << "flits"
+                    << std::setw(12) << "busy"
+                    << std::setw(12) << "util"
+                    << std::setw(12) << "busy stall"
+                    << std::setw(12) << "token stall"
+                    << std::endl;
+                header = true;
+            }
+            c->links[l]->print(this->now, file);
+        }
+    }
+    
+}
 
+void system_driver::print_profile(std::ostream* file) const
+{
+#if PROFILE == 1
+    static const char* const phase_names[NUM_PROFILE_PHASES] =
+        {"generate", "wake", "port_in", "retire"};
+    
+    // one row per component, then the totals.  Each phase gets a calls
+    // column and a kilocycles column
+    *file << std::endl << std::left << std::setw(30) << "component" << std::right;
+    for (unsigned phase = 0; phase < NUM_PROFILE_PHASES; phase++)
+    {
+        *file
+            << std::setw(12) << phase_names[phase]
+            << std::setw(12) << "kcycles";
+    }
+    *file << std::setw(12) << "rejected" << std::endl;
+    
+    profile_counters total = profile_counters();
+    unsigned num_resident_components = this->resident_components.size();
+    for (unsigned ix = 0; ix <= num_resident_components; ix++)
+    {
+        const profile_counters* row = &total;
+        std::string row_name = "total";
+        if (ix < num_resident_components)
+        {
+            row = &this->resident_components[ix]->profile_data;
+            row_name = this->resident_components[ix]->name;
+            for (unsigned phase = 0; phase < NUM_PROFILE_PHASES; phase++)
+            {
+                total.calls[phase] += row->calls[phase];
+                total.cycles[phase] += row->cycles[phase];
+            }
+            total.port_in_rejected += row->port_in_rejected;
+        }
+        
+        *file << std::left << std::setw(30) << row_name.substr(0, 29) << std::right;
+        for (unsigned phase = 0; phase < NUM_PROFILE_PHASES; phase++)
+        {
+            *file
+                << std::setw(12) << row->calls[phase]
+                << std::setw(12) << row->cycles[phase] / 1000;
+        }
+        *file << std::setw(12) << row->port_in_rejected << std::endl;
+    }
+#endif
+}
@@ -13,6 +13,11 @@
 #ifndef __HEADER_GUARD_SYSTEM_DRIVER__
 #define __HEADER_GUARD_SYSTEM_DRIVER__
 
+#include <climits>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <string>
 #include <vector>
 
 class component;
@@ -49,19 +54,263 @@ class system_driver
             component* c
         );
         
+        /// Compile every component's routes and check that they lead where
+        /// the components need them to, printing each problem found.  The
+        /// check is done once, after the last add_component(), and
+        /// simulate() and simulate_sampled() call it themselves and refuse
+        /// to simulate a system which fails it.
+        /// \return false if a problem was reported
+        bool check_routes();
+        
         /// Repeatedly call each registered components'
-        /// \ref component::generate "generate",
-        /// \ref component::advance_cooldowns "advance_cooldowns",
-        /// and \ref component::wake_packets "wake_packets"
+        /// \ref component::generate "generate" and wake the components
+        /// whose packets have cooled down through
+        /// \ref component::wake_packets "wake_packets".  Components are
+        /// kept in an event queue keyed on the absolute time their next
+        /// packet cools down, so idle components are never visited.
         /// \return the total number of ticks required to simulate the system
         /// to quiescence (no more packets are in flight nor can be generated)
-        unsigned long simulate();
+        /// or, if the simulation was stopped early, the number of ticks
+        /// simulated so far.  Calling simulate() again resumes where the
+        /// previous call stopped.
+        unsigned long simulate
+        (
+            /// [in] Stop at the end of the first step which reaches this
+            /// many elapsed ticks, for example to save_checkpoint() after
+            /// a warm-up period.
+            unsigned long stop_ticks = ULONG_MAX
+        );
+        
+        /// Estimate the time simulate() would report without simulating
+        /// the whole trace in detail.  Alternates between detailed windows
+        /// of detailed_ticks and functional fast-forwards of
+        /// functional_ticks.  While fast-forwarding, each component reads
+        /// its trace (see component::fast_forward) at the rate it managed
+        /// in the window before, and accesses only update the migration
+        /// tables and memory state.  Packets still in flight at the end of
+        /// a window wait for the next one.  Runs until quiescence and
+        /// prints the estimate along with a 95% confidence interval.
+        /// \return the estimated total number of ticks
+        unsigned long simulate_sampled
+        (
+            /// [in] Length of each detailed window
+            unsigned long detailed_ticks,
+            /// [in] Time skipped between detailed windows
+            unsigned long functional_ticks
+        );
+        
+        /// Write the state of the whole simulation to a binary file.
+        /// Restoring it into a system built the same way (the same
+        /// components added in the same order) continues the simulation
+        /// exactly where it was saved, even if parameters such as
+        /// epoch lengths or thresholds differ.
+        /// \return false if the file could not be written
+        bool save_checkpoint
+        (
+            /// [in] Path of the checkpoint to write
+            const std::string& filename
+        );
+        
+        /// Replace the state of all registered components with the
+        /// contents of a checkpoint made by save_checkpoint().
+        /// \return false if the file could not be read or was made from a
+        /// different system.
+        bool restore_checkpoint
+        (
+            /// [in] Path of the checkpoint to read
+            const std::string& filename
+        );
+        
+        /// \return The total number of packets destroyed by all
+        /// components, a measure of how much work the simulation did.
+        /// See component::get_packets_destroyed
+        unsigned long get_packets_destroyed() const;
+        
+        /// Print the utilization counters of every \ref hmc_link, see
+        /// component::add_link.  Called at the end of simulate(), prints
+        /// nothing if the system has no links.
+        void print_links
+        (
+            /// [out] Stream to print to
+            std::ostream* file = &(std::cout)
+        ) const;
+        
+        /// Print how many times each phase of the simulation ran on each
+        /// component and how many CPU cycles it took, see profile.h.
+        /// Called at the end of simulate() when PROFILE is enabled, does
+        /// nothing otherwise.
+        void print_profile
+        (
+            /// [out] Stream to print to
+            std::ostream* file = &(std::cout)
+        ) const;
+        
+        /// \return the component which was given index id by
+        /// add_component(), or NULL if there is none.
+        inline component* get_component(unsigned id) const
+        {
+            if (id >= this->resident_components.size())
+                return NULL;
+            return this->resident_components[id];
+        }
+        
+        /// Choose where simulate() and simulate_sampled() print their
+        /// results.  NULL prints nothing, which is useful when several
+        /// simulations run at once on different threads.
+        void set_output
+        (
+            /// [in] Stream to print to
+            std::ostream* output_ = &(std::cout)
+        );
+        
+        /// Called by a component whose component::next_wake moved earlier
+        /// because it accepted a packet.  Queues the component so it is
+        /// woken on time.
+        void schedule
+        (
+            /// [in] A component registered with this driver
+            component* c
+        );
+        
+        /// Called by a component whose component::generate_at moved
+        /// earlier.  Adds the component to the active set so generate()
+        /// is called on it.
+        void activate
+        (
+            /// [in] A component registered with this driver
+            component* c
+        );
+        
+        /// Called by component::release_waiting when c's blocked packets
+        /// can be retried.  Makes sure the clock stops at the time
+        /// returned.
+        /// \return The time a component polling every tick would have
+        /// retried them: now if c has yet to be woken in the current wake
+        /// pass, otherwise the next tick.
+        unsigned long retry_time
+        (
+            /// [in] A component registered with this driver
+            const component* c
+        );
+        
+        /// The simulated time which component::resident_wake and
+        /// component::ready_at are measured against.
+        inline unsigned long get_time() const
+        {
+            return this->now;
+        }
         
     protected:
         
+        /// An entry in the event queue.  Entries are never removed when a
+        /// component reschedules itself, so an entry whose time no longer
+        /// matches its component's component::next_wake is stale and is
+        /// skipped when it reaches the top of the queue.
+        struct wake_event
+        {
+            unsigned long time;
+            unsigned id;
+            
+            /// Order by time, then by component index so that components
+            /// due at the same time are woken in the order they were added
+            inline bool operator>(const wake_event& rhs) const
+            {
+                return this->time != rhs.time
+                    ? this->time > rhs.time
+                    : this->id > rhs.id;
+            }
+        };
+        
+        /// The main loop behind simulate() and simulate_sampled().  Runs
+        /// until quiescence or until stop_ticks elapsed ticks are reached.
+        /// \return The amount the clock will move at the start of the
+        /// next step, UINT_MAX if the system is quiescent
+        unsigned run(unsigned long stop_ticks);
+        
+        /// If the last step found the system quiescent, take back the
+        /// UINT_MAX ticks it added to system_driver::elapsed_ticks so
+        /// that simulation can resume.
+        void resume_after_quiescence();
+        
+        /// Fill in component::next_hop for every registered component from
+        /// its component::routing_table, then follow every route to its
+        /// destination and report any hop which is missing or leads out
+        /// of this system, or any route which loops.  Also reports every
+        /// pair listed by component::required_routes which has no first
+        /// hop.
+        /// \return false if a problem was reported
+        bool compile_routes();
+        
+        /// Pop stale entries off the top of system_driver::events.
+        void discard_stale_events();
+        
         /// These are all the components in the simulation.
         std::vector<component*> resident_components;
         
+        /// Min-heap of the absolute times at which components need to be
+        /// woken.
+        std::priority_queue
+        <
+            wake_event,
+            std::vector<wake_event>,
+            std::greater<wake_event>
+        > events;
+        
+        /// Components due during the wake pass currently in progress,
+        /// ordered by index.
+        std::priority_queue
+        <
+            unsigned,
+            std::vector<unsigned>,
+            std::greater<unsigned>
+        > due;
+        
+        /// due_flags[id] is set while a component is in system_driver::due
+        std::vector<bool> due_flags;
+        
+        /// The active set: indexes of the components which have asked for
+        /// generate() to be called.  Components leave the set once
+        /// generate() has been called and they have not asked again.
+        std::vector<unsigned> active;
+        
+        /// active_flags[id] is set while a component is in
+        /// system_driver::active
+        std::vector<bool> active_flags;
+        
+        /// Set once check_routes() has compiled the routes, cleared by
+        /// add_component()
+        bool routes_checked = false;
+        
+        /// What compile_routes() returned when check_routes() last ran
+        bool routes_valid = false;
+        
+        /// True while simulate() is inside a wake pass
+        bool waking = false;
+        
+        /// Index of the component currently being woken
+        unsigned waking_id = 0;
+        
+        /// See get_time()
+        unsigned long now = 0;
+        
+        /// Total simulated time reported by simulate().  Runs one step
+        /// ahead of system_driver::now, which only moves at the start of
+        /// the step.
+        unsigned long elapsed_ticks = 0;
+        
+        /// Amount system_driver::now moves at the start of the next step
+        unsigned advancement_amount = 0;
+        
+        /// Lowest cooldown handed out by retry_time() during the current
+        /// wake pass
+        unsigned retry_cooldown = UINT_MAX;
+        
+        /// Number of steps taken, only used for debugging output
+        unsigned iteration = 1;
+        
+        /// See set_output()
+        std::ostream* output = &(std::cout);
+        
 };
 
 #endif // header guard
@@ -0,0 +1,384 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              topology.cpp \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include "controller_global.h"
+#include "cpu.h"
+#include "hmc_cube.h"
+#include "memory.h"
+#include "synthetic_cpu.h"
+#include "topology.h"
+
+// The memory modules are laid out in a grid with 4 modules per row, one
+// row for 1 and 2 CPUs and two rows for 4 CPUs.  Each CPU hangs off the
+// controller next to its home module:
+//
+// 1 CPU:   CPU0 -- MODULE0 -- MODULE1 -- MODULE2 -- MODULE3
+//
+// 2 CPUs:  CPU0 -- MODULE0 -- MODULE1 -- MODULE2 -- MODULE3 -- CPU1
+//
+// 4 CPUs:  CPU0 -- MODULE0 -- MODULE1 -- MODULE2 -- MODULE3 -- CPU2
+//                     |          |          |          |
+//          CPU1 -- MODULE4 -- MODULE5 -- MODULE6 -- MODULE7 -- CPU3
+//
+// Between modules packets travel between rows first, then along the row.
+// Towards a CPU they travel along the row first, then between rows.
+static const unsigned modules_per_row = 4;
+
+topology_config default_topology(unsigned num_cpus)
+{
+
+    topology_config config;
+    config.num_cpus = num_cpus;
+    config.link_lanes = 0;
+    config.link_lane_rate = 10;
+    config.link_tokens = 64;
+    config.core_rob_size = 0;
+    config.core_issue_width = 4;
+    config.core_load_queue = 32;
+    config.core_store_queue = 32;
+    config.l1_size = 0;
+    config.l2_size = 0;
+    config.l1_ways = 8;
+    config.l1_latency = 4;
+    config.l2_ways = 8;
+    config.l2_latency = 12;
+    config.cache_plru = false;
+    config.dram_banks = 0;
+    config.dram_fcfs = false;
+    config.hmc_vaults = 0;
+    if (num_cpus == 1)
+    {
+        config.page_size = 8192;
+        config.epoch_length = 2000;
+        config.cost_threshold = 100;
+        config.diff_threshold = 10;
+    }
+    else if (num_cpus == 2)
+    {
+        config.page_size = 4096;
+        config.epoch_length = 200;
+        config.cost_threshold = 30;
+        config.diff_threshold = 0;
+    }
+    else
+    {
+        config.page_size = 4096;
+        config.epoch_length = 5000;
+        config.cost_threshold = 400;
+        config.diff_threshold = 40;
+    }
+    return config;
+
+}
+
+// One step from module 'from' towards module 'to'.  rows_first picks
+// which direction is travelled first.
+static unsigned step_towards(unsigned from, unsigned to, bool rows_first)
+{
+
+    unsigned from_row = from / modules_per_row;
+    unsigned from_col = from % modules_per_row;
+    unsigned to_row = to / modules_per_row;
+    unsigned to_col = to % modules_per_row;
+
+    if (from_row != to_row && (rows_first || from_col == to_col))
+        return to_row > from_row ? from + modules_per_row : from - modules_per_row;
+    return to_col > from_col ? from + 1 : from - 1;
+
+}
+
+// Give a new CPU the core model and caches config asks for
+static void configure_cpu(cpu* c, const topology_config& config)
+{
+    c->set_core(config.core_rob_size, config.core_issue_width, config.core_load_queue, config.core_store_queue);
+    cache::replacement_policy policy = config.cache_plru ? cache::PLRU : cache::LRU;
+    if (config.l1_size > 0)
+        c->add_cache(config.l1_size, config.l1_ways, config.l1_latency, 64, policy);
+    if (config.l2_size > 0)
+        c->add_cache(config.l2_size, config.l2_ways, config.l2_latency, 64, policy);
+}
+
+// Print an error and return false unless there is a topology for
+// config.num_cpus and num_workloads workloads, one per CPU
+static bool check_cpu_count(const topology_config& config, size_t num_workloads)
+{
+    if (config.num_cpus != 1 && config.num_cpus != 2 && config.num_cpus != 4)
+    {
+        std::cerr << "Error. There is no topology with " << config.num_cpus << " CPUs" << std::endl;
+        return false;
+    }
+    if (num_workloads != config.num_cpus)
+    {
+        std::cerr
+            << "Error. A " << config.num_cpus << " CPU topology needs "
+            << config.num_cpus << " traces, not " << num_workloads
+            << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Everything build_topology does once the CPUs exist
+static system_driver* build_system
+(
+    const topology_config& config,
+    const std::vector<cpu*>& cpus
+){
+
+    // Home module of each CPU, see the diagram above
+    std::vector<unsigned> homes;
+    unsigned num_mem;
+    uint64_t module_size;
+    unsigned max_resident_packets;
+    unsigned routing_latency;
+    unsigned cooldown;
+    unsigned address_length;
+    unsigned internal_address_length;
+    if (config.num_cpus == 1)
+    {
+        homes = {0};
+        num_mem = 4;
+        module_size = 0x10000000;
+        max_resident_packets = 16;
+        routing_latency = 0;
+        cooldown = 0;
+        address_length = 30;
+        internal_address_length = 28;
+    }
+    else if (config.num_cpus == 2)
+    {
+        homes = {0, 3};
+        num_mem = 4;
+        module_size = 0x40000000;
+        max_resident_packets = 32;
+        routing_latency = 1;
+        cooldown = 0;
+        address_length = 32;
+        internal_address_length = 30;
+    }
+    else
+    {
+        homes = {0, 4, 3, 7};
+        num_mem = 8;
+        module_size = 0x40000000;
+        max_resident_packets = 32;
+        routing_latency = 1;
+        cooldown = 1;
+        address_length = 33;
+        internal_address_length = 30;
+    }
+
+    // memory only takes 32 bit addresses, as in main_4cpu.cpp
+    std::vector<memory*> modules;
+    std::vector<hmc_cube*> cubes;
+    for (unsigned ix = 0; ix < num_mem; ix++)
+    {
+        std::stringstream name;
+        name << "M" << ix;
+        uint64_t first_address = module_size * ix;
+        if (config.hmc_vaults > 0)
+        {
+            cubes.push_back(new hmc_cube(first_address, first_address + module_size - 1, name.str(), config.hmc_vaults));
+            modules.push_back(cubes.back());
+        }
+        else
+        {
+            modules.push_back(new memory(first_address, first_address + module_size - 1, name.str(), 1, UINT_MAX, 10, 32, 4));
+        }
+        if (config.dram_banks > 0)
+            modules.back()->set_banks(config.dram_banks);
+        if (config.dram_fcfs)
+            modules.back()->set_scheduler(memory::FCFS);
+    }
+
+    controller_global* CONTROLLER = new controller_global
+    (
+        // -- Simulator Information
+        "Global Migration Controller", // Name
+        0, // Initiation Interval
+        max_resident_packets, // Max Resident Packets
+        routing_latency, // Routing Latency
+        cooldown, // Cooldown
+
+        // -- System Configuration
+        0, // First Address
+        module_size * num_mem - 1, // Last Address
+
+        // -- CPU Configuration
+        config.num_cpus, // Number of CPUs
+
+        // -- Memory Configuration
+        num_mem, // Number of HMC Modules
+        address_length, // Address Length
+        internal_address_length, // Internal Address Length (Per HMC Module)
+        config.page_size, // Page Size (in Bytes)
+        config.epoch_length, // Epoch Length (in Cycles)
+        config.cost_threshold, // Cost of Threshold
+        config.diff_threshold // Difference Threshold
+    );
+
+    // Add CPU and Modules to Controller
+    for (unsigned c = 0; c < config.num_cpus; c++)
+        CONTROLLER->add_Cpu(cpus[c]);
+    for (unsigned m = 0; m < num_mem; m++)
+        CONTROLLER->add_Module(modules[m]);
+
+    // Distance is one more than the number of hops from the CPU's home
+    for (unsigned c = 0; c < config.num_cpus; c++)
+    {
+        for (unsigned m = 0; m < num_mem; m++)
+        {
+            unsigned row = m / modules_per_row;
+            unsigned col = m % modules_per_row;
+            unsigned home_row = homes[c] / modules_per_row;
+            unsigned home_col = homes[c] % modules_per_row;
+            unsigned distance = 1
+                + (row > home_row ? row - home_row : home_row - row)
+                + (col > home_col ? col - home_col : home_col - col);
+            CONTROLLER->add_Distance(cpus[c], modules[m], distance);
+        }
+    }
+
+    // Add Routing
+    for (unsigned c = 0; c < config.num_cpus; c++)
+    {
+        cpus[c]->add_route(CONTROLLER, CONTROLLER);
+        cpus[c]->add_addressable(CONTROLLER);
+
+        // Controller Routing to memory varies by CPU
+        // Specified in port_out of controller
+        CONTROLLER->add_route(cpus[c], cpus[c]);
+    }
+
+    for (unsigned m = 0; m < num_mem; m++)
+    {
+        // Towards a CPU
+        for (unsigned c = 0; c < config.num_cpus; c++)
+        {
+            if (m == homes[c])
+                modules[m]->add_route(cpus[c], CONTROLLER);
+            else
+                modules[m]->add_route(cpus[c], modules[step_towards(m, homes[c], false)]);
+        }
+
+        // Towards the controller, through the nearest home module in
+        // this row
+        unsigned nearest = UINT_MAX;
+        unsigned nearest_distance = UINT_MAX;
+        for (unsigned c = 0; c < config.num_cpus; c++)
+        {
+            if (homes[c] / modules_per_row != m / modules_per_row)
+                continue;
+            unsigned distance = homes[c] > m ? homes[c] - m : m - homes[c];
+            if (distance < nearest_distance)
+            {
+                nearest = homes[c];
+                nearest_distance = distance;
+            }
+        }
+        if (nearest == m)
+            modules[m]->add_route(CONTROLLER, CONTROLLER);
+        else if (nearest != UINT_MAX)
+            modules[m]->add_route(CONTROLLER, modules[step_towards(m, nearest, false)]);
+
+        // Towards other modules
+        for (unsigned t = 0; t < num_mem; t++)
+        {
+            if (t != m)
+                modules[m]->add_route(modules[t], modules[step_towards(m, t, true)]);
+        }
+    }
+
+    // Links follow the physical connections: each CPU to the controller,
+    // the controller to each home module (and M0, where swap requests
+    // enter) and each module to its neighbours in the grid
+    if (config.link_lanes > 0)
+    {
+        std::vector<std::pair<component*, component*> > connections;
+        for (unsigned c = 0; c < config.num_cpus; c++)
+            connections.push_back({cpus[c], CONTROLLER});
+        for (unsigned m = 0; m < num_mem; m++)
+        {
+            bool home = m == 0;
+            for (unsigned c = 0; c < config.num_cpus; c++)
+                home = home || homes[c] == m;
+            if (home)
+                connections.push_back({CONTROLLER, modules[m]});
+            if ((m + 1) % modules_per_row != 0 && m + 1 < num_mem)
+                connections.push_back({modules[m], modules[m + 1]});
+            if (m + modules_per_row < num_mem)
+                connections.push_back({modules[m], modules[m + modules_per_row]});
+        }
+        for (unsigned ix = 0; ix < connections.size(); ix++)
+        {
+            component* a = connections[ix].first;
+            component* b = connections[ix].second;
+            a->add_link(b, config.link_lanes, config.link_lane_rate, config.link_tokens);
+            b->add_link(a, config.link_lanes, config.link_lane_rate, config.link_tokens);
+        }
+    }
+
+    // Register all components with a system driver which
+    // drives packets generation/routing/retirement
+    system_driver* motherboard = new system_driver;
+    for (unsigned c = 0; c < config.num_cpus; c++)
+        motherboard->add_component(cpus[c]);
+    motherboard->add_component(CONTROLLER);
+    for (unsigned m = 0; m < num_mem; m++)
+        motherboard->add_component(modules[m]);
+    for (unsigned m = 0; m < cubes.size(); m++)
+        cubes[m]->add_vaults(motherboard);
+
+    return motherboard;
+
+}
+
+system_driver* build_topology
+(
+    const topology_config& config,
+    const std::vector<const trace*>& traces
+){
+    if (!check_cpu_count(config, traces.size()))
+        return NULL;
+    std::vector<cpu*> cpus;
+    for (unsigned ix = 0; ix < config.num_cpus; ix++)
+    {
+        std::stringstream name;
+        name << "CPU" << ix;
+        cpus.push_back(new cpu(traces[ix], name.str()));
+        configure_cpu(cpus.back(), config);
+    }
+    return build_system(config, cpus);
+}
+
+system_driver* build_topology
+(
+    const topology_config& config,
+    const std::vector<synthetic_config>& workloads
+){
+    if (!check_cpu_count(config, workloads.size()))
+        return NULL;
+    std::vector<cpu*> cpus;
+    for (unsigned ix = 0; ix < config.num_cpus; ix++)
+    {
+        std::stringstream name;
+        name << "CPU" << ix;
+        cpus.push_back(new synthetic_cpu(workloads[ix], name.str()));
+        configure_cpu(cpus.back(), config);
+    }
+    return build_system(config, cpus);
+}
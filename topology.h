@@ -0,0 +1,118 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              topology.h \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#ifndef __HEADER_GUARD_TOPOLOGY__
+#define __HEADER_GUARD_TOPOLOGY__
+
+#include <vector>
+#include "synthetic_cpu.h"
+#include "system_driver.h"
+#include "trace.h"
+
+/// The parameters of one of the reference systems built by main.cpp
+/// (1 CPU), main_2cpu.cpp (2 CPUs) and main_4cpu.cpp (4 CPUs) which
+/// experiments usually vary.
+struct topology_config
+{
+    /// 1, 2 or 4.  Picks the topology.
+    unsigned num_cpus;
+
+    /// See controller_global::controller_global
+    unsigned page_size;
+    unsigned epoch_length;
+    unsigned cost_threshold;
+    unsigned diff_threshold;
+
+    /// Lanes in each direction of the \ref hmc_link "links" between
+    /// neighbouring components, see component::add_link.  0 leaves the
+    /// components connected ideally, as the main*.cpp programs do.
+    unsigned link_lanes;
+
+    /// See hmc_link::lane_rate and hmc_link::max_tokens
+    unsigned link_lane_rate;
+    unsigned link_tokens;
+
+    /// Reorder buffer size of the out-of-order core model given to every
+    /// CPU, see cpu::set_core.  0 keeps the simple model the main*.cpp
+    /// programs use.
+    unsigned core_rob_size;
+
+    /// See cpu::set_core
+    unsigned core_issue_width;
+    unsigned core_load_queue;
+    unsigned core_store_queue;
+
+    /// Capacity in bytes of the private L1 and L2 cache given to every
+    /// CPU, see cpu::add_cache.  0 leaves the level out, as the main*.cpp
+    /// programs do.
+    unsigned l1_size;
+    unsigned l2_size;
+
+    /// See cpu::add_cache
+    unsigned l1_ways;
+    unsigned l1_latency;
+    unsigned l2_ways;
+    unsigned l2_latency;
+
+    /// Use PLRU rather than LRU replacement in the caches, see
+    /// cache::policy
+    bool cache_plru;
+    /// Banks each memory module is split into, see memory::set_banks,
+    /// with default_dram_timing().  0 keeps the single row buffer the
+    /// main*.cpp programs use.
+    unsigned dram_banks;
+
+    /// Serve each bank's requests in the order they arrive rather than
+    /// FR-FCFS, see memory::set_scheduler
+    bool dram_fcfs;
+
+    /// Vaults in each \ref hmc_cube standing in for a memory module, 0
+    /// for plain memory modules as the main*.cpp programs use.  The
+    /// vaults rather than the modules are split into dram_banks banks.
+    unsigned hmc_vaults;
+};
+
+/// \return The configuration the main*.cpp program for num_cpus uses
+topology_config default_topology
+(
+    /// [in] 1, 2 or 4
+    unsigned num_cpus
+);
+
+/// Build one of the reference systems, with the CPUs reading traces
+/// which have already been parsed.  Except for the traces and the
+/// parameters in config, the system is identical to the one built by
+/// the main*.cpp program for config.num_cpus, so it simulates to the
+/// same result.
+/// \return A new system ready for system_driver::simulate, which the
+/// caller must delete, or NULL if config.num_cpus is not supported or
+/// there is not one trace per CPU.
+system_driver* build_topology
+(
+    /// [in] Which system to build and how to configure its controller
+    const topology_config& config,
+    /// [in] One trace per CPU.  They must outlive the returned system.
+    const std::vector<const trace*>& traces
+);
+
+/// Build one of the reference systems with \ref synthetic_cpu "CPUs"
+/// which make up their accesses instead of reading traces.
+/// \return As for the other build_topology
+system_driver* build_topology
+(
+    /// [in] Which system to build and how to configure its controller
+    const topology_config& config,
+    /// [in] What each CPU accesses, one per CPU
+    const std::vector<synthetic_config>& workloads
+);
+
+#endif // header guard
@@ -0,0 +1,501 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              trace.cpp \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "trace.h"
+
+#ifdef _WIN32
+    #include <iterator>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// See binary_trace_reader for the layout
+static const char binary_trace_magic[8] = {'H', 'M', 'C', 'T', 'R', 'A', 'C', 'E'};
+static const char binary_trace_dependency_magic[8] = {'H', 'M', 'C', 'T', 'R', 'D', 'E', 'P'};
+static const char binary_trace_gap_magic[8] = {'H', 'M', 'C', 'T', 'R', 'G', 'A', 'P'};
+static const std::size_t binary_trace_header = sizeof(binary_trace_magic) + sizeof(uint64_t);
+
+bool parse_trace_line(const std::string& line, trace_record& record)
+{
+
+    std::istringstream iss(line);
+    std::string word;
+
+    // The access type is at most the third word on the line
+    for (unsigned ix = 0; ix < 3; ix++)
+    {
+        if (!(iss >> word) || word.at(0) == '#')
+            return false;
+        if (word == "R" || word == "W")
+        {
+            record.rw = word.at(0);
+            if (!(iss >> std::hex >> record.address))
+                return false;
+
+            // hints are words after the address, up to any comment
+            record.depends = 0;
+            record.gap = 0;
+            while (iss >> word && word.at(0) != '#')
+            {
+                if (word.compare(0, 4, "dep=") == 0)
+                    record.depends = (uint32_t)strtoul(word.c_str() + 4, NULL, 10);
+                else if (word.compare(0, 4, "gap=") == 0)
+                    record.gap = (uint32_t)strtoul(word.c_str() + 4, NULL, 10);
+            }
+            return true;
+        }
+    }
+    return false;
+
+}
+
+// Decode a number stored 7 bits per byte with a continuation bit, as the
+// dependency distances and gaps are, and move at past it
+// \return false if the number is cut off by end
+static inline bool read_varint(const unsigned char*& at, const unsigned char* end, uint32_t& value)
+{
+    value = 0;
+    unsigned shift = 0;
+    unsigned char byte;
+    do
+    {
+        if (at == end)
+            return false;
+        byte = *at++;
+        if (shift < 32)
+            value |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+    }
+    while (byte & 0x80);
+    return true;
+}
+
+// Append value to block 7 bits per byte with a continuation bit
+static inline void write_varint(std::vector<unsigned char>& block, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        block.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    block.push_back(value);
+}
+
+binary_trace_reader::binary_trace_reader()
+{
+    this->data = NULL;
+    this->length = 0;
+    this->offset = 0;
+    this->last_address = 0;
+    this->position = 0;
+    this->num_records = 0;
+    this->dependencies = false;
+    this->gaps = false;
+}
+
+binary_trace_reader::~binary_trace_reader()
+{
+    this->close();
+}
+
+bool binary_trace_reader::open(const std::string& filename)
+{
+
+    this->close();
+
+#ifdef _WIN32
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file.good())
+        return false;
+    this->contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (this->contents.size() < binary_trace_header)
+    {
+        this->contents.clear();
+        return false;
+    }
+    this->data = this->contents.data();
+    this->length = this->contents.size();
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (std::size_t)status.st_size < binary_trace_header)
+    {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+    this->data = (const unsigned char*)mapping;
+    this->length = status.st_size;
+#endif
+
+    uint64_t count;
+    memcpy(&count, this->data + sizeof(binary_trace_magic), sizeof(count));
+    this->gaps = memcmp(this->data, binary_trace_gap_magic, sizeof(binary_trace_gap_magic)) == 0;
+    this->dependencies = this->gaps || memcmp(this->data, binary_trace_dependency_magic, sizeof(binary_trace_dependency_magic)) == 0;
+    if (!this->dependencies && memcmp(this->data, binary_trace_magic, sizeof(binary_trace_magic)) != 0)
+    {
+        this->close();
+        return false;
+    }
+    this->num_records = count;
+    return this->seek(0);
+
+}
+
+void binary_trace_reader::close()
+{
+    if (this->data != NULL)
+    {
+#ifdef _WIN32
+        this->contents.clear();
+#else
+        munmap((void*)this->data, this->length);
+#endif
+    }
+    this->data = NULL;
+    this->length = 0;
+    this->num_records = 0;
+    this->dependencies = false;
+    this->gaps = false;
+    this->offset = 0;
+    this->last_address = 0;
+    this->position = 0;
+}
+
+unsigned long binary_trace_reader::read(trace_record* records, unsigned long max_records)
+{
+
+    if (this->num_records - this->position < max_records)
+        max_records = this->num_records - this->position;
+
+    const unsigned char* at = this->data + this->offset;
+    const unsigned char* end = this->data + this->length;
+    uint64_t address = this->last_address;
+    unsigned long count = 0;
+    for (; count < max_records && at < end; count++)
+    {
+        // first byte: continuation, 6 bits of the delta, write flag
+        unsigned char byte = *at++;
+        records[count].rw = (byte & 0x01) ? 'W' : 'R';
+        uint64_t zigzag = (byte >> 1) & 0x3F;
+        unsigned shift = 6;
+        while ((byte & 0x80) && at < end && shift < 64)
+        {
+            byte = *at++;
+            zigzag |= (uint64_t)(byte & 0x7F) << shift;
+            shift += 7;
+        }
+        // a record cut off by the end of the file is corrupt, drop it
+        if (byte & 0x80)
+            break;
+        address += (zigzag >> 1) ^ (0 - (zigzag & 1));
+        records[count].address = address;
+        records[count].depends = 0;
+        records[count].gap = 0;
+        if (this->dependencies && !read_varint(at, end, records[count].depends))
+            break;
+        if (this->gaps && !read_varint(at, end, records[count].gap))
+            break;
+    }
+
+    this->offset = at - this->data;
+    this->last_address = address;
+    this->position += count;
+    return count;
+
+}
+
+bool binary_trace_reader::seek(unsigned long record_index)
+{
+
+    if (this->data == NULL || record_index > this->num_records)
+        return false;
+
+    if (record_index < this->position || this->offset == 0)
+    {
+        this->offset = binary_trace_header;
+        this->last_address = 0;
+        this->position = 0;
+    }
+
+    // decode into a scratch buffer until we get there
+    trace_record scratch[256];
+    while (this->position < record_index)
+    {
+        unsigned long batch = record_index - this->position;
+        if (batch > sizeof(scratch) / sizeof(scratch[0]))
+            batch = sizeof(scratch) / sizeof(scratch[0]);
+        if (this->read(scratch, batch) != batch)
+            return false;
+    }
+    return true;
+
+}
+
+trace_stream::trace_stream()
+{
+    this->head = 0;
+    this->tail = 0;
+    this->finished = false;
+    this->stopping = false;
+    this->ended = false;
+    this->first_record = 0;
+}
+
+trace_stream::~trace_stream()
+{
+    this->close();
+}
+
+bool trace_stream::open(const std::string& filename_, unsigned long first_record_)
+{
+
+    this->close();
+    this->filename = filename_;
+    this->first_record = first_record_;
+
+    if (!this->binary.open(filename_))
+    {
+        this->text.clear();
+        this->text.open(filename_.c_str());
+        if (!this->text.good())
+            return false;
+    }
+
+    this->ring.resize(ring_records);
+    this->head = 0;
+    this->tail = 0;
+    this->finished = false;
+    this->stopping = false;
+    this->ended = false;
+    this->reader = std::thread(&trace_stream::fill, this);
+    return true;
+
+}
+
+void trace_stream::close()
+{
+    if (this->reader.joinable())
+    {
+        this->stopping.store(true, std::memory_order_release);
+        this->reader.join();
+    }
+    if (this->text.is_open())
+        this->text.close();
+    this->binary.close();
+}
+
+bool trace_stream::wait_for_space()
+{
+    // the ring is refilled half at a time, so the background thread
+    // sleeps while the simulation works through the other half
+    while
+    (
+        this->tail.load(std::memory_order_relaxed)
+      - this->head.load(std::memory_order_acquire)
+      > ring_records / 2
+    ){
+        if (this->stopping.load(std::memory_order_acquire))
+            return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return !this->stopping.load(std::memory_order_acquire);
+}
+
+void trace_stream::fill()
+{
+
+    bool is_binary = this->binary.is_open();
+    unsigned long skip = this->first_record;
+    if (is_binary)
+    {
+        if (!this->binary.seek(skip))
+        {
+            this->finished.store(true, std::memory_order_release);
+            return;
+        }
+        skip = 0;
+    }
+
+    std::string line;
+    trace_record r;
+    bool done = false;
+    while (!done && this->wait_for_space())
+    {
+        unsigned long position = this->tail.load(std::memory_order_relaxed);
+        unsigned long space = ring_records - (position - this->head.load(std::memory_order_acquire));
+        unsigned long count = 0;
+        if (is_binary)
+        {
+            // decode straight into the ring, up to where it wraps
+            unsigned long start = position & (ring_records - 1);
+            if (space > ring_records - start)
+                space = ring_records - start;
+            count = this->binary.read(&this->ring[start], space);
+            done = count < space;
+        }
+        else
+        {
+            while (count < space)
+            {
+                // as in trace::load, a last line with no newline is dropped
+                if (!getline(this->text, line) || !this->text.good())
+                {
+                    done = true;
+                    break;
+                }
+                if (!parse_trace_line(line, r))
+                    continue;
+                if (skip > 0)
+                {
+                    skip--;
+                    continue;
+                }
+                this->ring[(position + count) & (ring_records - 1)] = r;
+                count++;
+            }
+        }
+        this->tail.store(position + count, std::memory_order_release);
+    }
+    this->finished.store(true, std::memory_order_release);
+
+}
+
+bool write_binary_trace(const std::string& filename, const std::vector<trace_record>& records)
+{
+
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    if (!out.good())
+    {
+        std::cerr << "Error. Failed to open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    // plain traces keep the smaller layouts without dependency distances
+    // or gaps
+    bool dependencies = false;
+    bool gaps = false;
+    for (unsigned long ix = 0; ix < records.size() && !gaps; ix++)
+    {
+        dependencies = dependencies || records[ix].depends != 0;
+        gaps = records[ix].gap != 0;
+    }
+    dependencies = dependencies || gaps;
+
+    uint64_t count = records.size();
+    const char* magic = gaps
+        ? binary_trace_gap_magic
+        : dependencies ? binary_trace_dependency_magic : binary_trace_magic;
+    out.write(magic, sizeof(binary_trace_magic));
+    out.write((const char*)&count, sizeof(count));
+
+    // encode a block of records at a time
+    std::vector<unsigned char> block;
+    block.reserve(4096 * 10);
+    uint64_t last_address = 0;
+    for (unsigned long ix = 0; ix < records.size(); ix++)
+    {
+        int64_t delta = (int64_t)(records[ix].address - last_address);
+        uint64_t zigzag = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+        last_address = records[ix].address;
+
+        unsigned char byte = ((zigzag & 0x3F) << 1) | (records[ix].rw == 'W' ? 0x01 : 0x00);
+        zigzag >>= 6;
+        while (zigzag != 0)
+        {
+            block.push_back(byte | 0x80);
+            byte = zigzag & 0x7F;
+            zigzag >>= 7;
+        }
+        block.push_back(byte);
+
+        if (dependencies)
+            write_varint(block, records[ix].depends);
+        if (gaps)
+            write_varint(block, records[ix].gap);
+
+        if (block.size() >= 4096 * 9)
+        {
+            out.write((const char*)block.data(), block.size());
+            block.clear();
+        }
+    }
+    out.write((const char*)block.data(), block.size());
+
+    if (!out.good())
+    {
+        std::cerr << "Error. Failed to write " << filename << std::endl;
+        return false;
+    }
+    return true;
+
+}
+
+trace::trace() {}
+
+bool trace::load(const std::string& filename_)
+{
+
+    std::ifstream trace_file(filename_.c_str());
+    if (!trace_file.good())
+    {
+        std::cerr
+            << "Error. Failed to open "
+            << filename_
+            << " for reading"
+            << std::endl;
+        return false;
+    }
+
+    this->filename = filename_;
+    this->records.clear();
+
+    binary_trace_reader reader;
+    if (reader.open(filename_))
+    {
+        this->records.resize(reader.size());
+        this->records.resize(reader.read(this->records.data(), reader.size()));
+        return true;
+    }
+
+    std::string line;
+    trace_record r;
+    while (getline(trace_file, line))
+    {
+        // cpu::generate() stops as soon as the stream goes bad, even if it
+        // just read a line, so the last line only counts if a newline
+        // follows it
+        if (!trace_file.good())
+            break;
+        if (parse_trace_line(line, r))
+            this->records.push_back(r);
+    }
+
+    return true;
+
+}
@@ -0,0 +1,391 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              trace.h \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+#ifndef __HEADER_GUARD_TRACE__
+#define __HEADER_GUARD_TRACE__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// One memory access read from a trace
+struct trace_record
+{
+    /// Address of the access
+    uint64_t address;
+
+    /// Number of accesses back in the trace to the access whose result
+    /// this one needs before it can issue, or 0 if it needs none.  Only
+    /// the out-of-order core model uses it, see cpu::set_core.
+    uint32_t depends;
+
+    /// Cycles of compute between the access before this one and this
+    /// one.  The CPU sends (or with an out-of-order core, dispatches) the
+    /// access no sooner than this long after the one before it, so 0
+    /// means as soon as the memory system takes it.
+    uint32_t gap;
+
+    /// 'R' or 'W'
+    char rw;
+};
+
+/// Parse one line of a memory trace.  Three layouts are understood:
+///     <thread> <time> R|W <hex address>       (PARSEC traces)
+///     R|W <hex address>                       (traces/)
+///     R|W 0x<address> <bytes> <data> ...      (trace_w256_h256_r2.txt)
+/// The access type is the word R or W exactly.  Of the words after the
+/// address, up to any '#' comment, a dependency hint dep=<n> sets
+/// trace_record::depends to the decimal n and a compute hint gap=<n> sets
+/// trace_record::gap; the others are ignored.  For example
+/// "R 1140 dep=2 gap=30" reads an address computed from the access two
+/// before it, 30 cycles after the access before it.
+/// \return false if the line holds no access, such as a blank line or a
+/// '#' comment.
+bool parse_trace_line
+(
+    /// [in] A line of the trace, without the newline
+    const std::string& line,
+    /// [out] The access
+    trace_record& record
+);
+
+/// \class binary_trace_reader
+/// Reads a binary trace written by write_binary_trace().  The file is
+/// memory mapped and decoded in place, many records per call to read(),
+/// without allocating anything after open().
+///
+/// A binary trace starts with the 8 bytes "HMCTRACE" and the number of
+/// records as a 64 bit integer in host byte order (like the checkpoints,
+/// see checkpoint.h).  Each record follows as a variable length integer:
+/// the zigzag encoded difference between its address and the previous
+/// record's address (0 before the first record).  The first byte holds a
+/// continuation bit (0x80), the low 6 bits of the difference and whether
+/// the access is a write (0x01).  Every following byte holds a
+/// continuation bit and 7 more bits.  Sequential traces take 1 or 2 bytes
+/// per record.
+///
+/// Traces with dependency hints (see trace_record::depends) start with
+/// "HMCTRDEP" instead, and each record is followed by its dependency
+/// distance, 7 bits per byte with a continuation bit.  Traces with
+/// compute gaps (see trace_record::gap) start with "HMCTRGAP", and each
+/// record is followed by its dependency distance and then its gap, in
+/// the same way.
+class binary_trace_reader
+{
+
+    public:
+
+        /// Creates a reader with no file open
+        binary_trace_reader();
+
+        /// Readers hold a mapping of their file, so they can not be copied
+        binary_trace_reader(const binary_trace_reader& rhs) = delete;
+        binary_trace_reader& operator=(const binary_trace_reader& rhs) = delete;
+
+        /// Calls close()
+        ~binary_trace_reader();
+
+        /// Map filename and get ready to read its first record.  Closes
+        /// any file which was already open.
+        /// \return false if filename could not be opened or is not a binary
+        /// trace.  Nothing is printed, so callers can use this to find out
+        /// whether a trace is binary or text.
+        bool open
+        (
+            /// [in] Path of a binary trace
+            const std::string& filename
+        );
+
+        /// Unmap the file
+        void close();
+
+        /// \return true between a successful open() and close()
+        inline bool is_open() const
+        {
+            return this->data != NULL;
+        }
+
+        /// Decode the next records of the trace
+        /// \return The number of records decoded, at most max_records.
+        /// Less than max_records only at the end of the trace, or if the
+        /// trace is corrupt.
+        unsigned long read
+        (
+            /// [out] At least max_records records to decode into
+            trace_record* records,
+            /// [in] Size of records
+            unsigned long max_records
+        );
+
+        /// Move to record number record_index, counting from 0.  Records
+        /// are delta encoded, so this decodes everything before it.
+        /// \return false if the trace has fewer records
+        bool seek
+        (
+            /// [in] Index of the next record read() should return
+            unsigned long record_index
+        );
+
+        /// \return The index of the next record read() will return
+        inline unsigned long tell() const
+        {
+            return this->position;
+        }
+
+        /// \return The number of records in the trace
+        inline unsigned long size() const
+        {
+            return this->num_records;
+        }
+
+    protected:
+
+        /// The mapped file, or NULL if none is open
+        const unsigned char* data;
+
+        /// Size of the mapped file in bytes
+        std::size_t length;
+
+        /// Offset in data of the next record
+        std::size_t offset;
+
+        /// Address of the last record decoded, the base of the next delta
+        uint64_t last_address;
+
+        /// See tell()
+        unsigned long position;
+
+        /// See size()
+        unsigned long num_records;
+
+        /// True if every record is followed by a dependency distance
+        bool dependencies;
+
+        /// True if every record is followed by a dependency distance and
+        /// a gap
+        bool gaps;
+
+#ifdef _WIN32
+        /// Without mmap() the file is read into memory instead
+        std::vector<unsigned char> contents;
+#endif
+
+};
+
+/// \class trace_stream
+/// Streams a trace file, text or binary (see binary_trace_reader), for a
+/// \ref cpu.  A background thread reads and decodes the file into a ring
+/// of records ahead of the simulation, half a ring at a time, so the
+/// simulation thread only ever takes records out of memory.  The ring is
+/// lock free with a single reader and a single writer.  The end of the
+/// trace is reached once the background thread has finished and the ring
+/// is empty.
+///
+/// Like trace::load, a last line with no newline after it is dropped
+/// from text traces.
+class trace_stream
+{
+
+    public:
+
+        /// Creates a stream with no file open
+        trace_stream();
+
+        /// The background thread refers to the stream, so it can not be
+        /// copied
+        trace_stream(const trace_stream& rhs) = delete;
+        trace_stream& operator=(const trace_stream& rhs) = delete;
+
+        /// Calls close()
+        ~trace_stream();
+
+        /// Open filename and start reading it in the background.  Closes
+        /// any file which was already open.
+        /// \return false if filename could not be opened
+        bool open
+        (
+            /// [in] Path of a text or binary trace
+            const std::string& filename_,
+            /// [in] Number of records to skip, see tell()
+            unsigned long first_record = 0
+        );
+
+        /// Stop the background thread and close the file
+        void close();
+
+        /// \return true between a successful open() and close()
+        inline bool is_open() const
+        {
+            return this->reader.joinable();
+        }
+
+        /// Take the next record out of the ring, waiting for the
+        /// background thread if it has not decoded it yet.
+        /// \return false at the end of the trace
+        inline bool pop(trace_record& record)
+        {
+            unsigned long position = this->head.load(std::memory_order_relaxed);
+            while (position == this->tail.load(std::memory_order_acquire))
+            {
+                // tail is published before finished, so check it again
+                if
+                (
+                    this->finished.load(std::memory_order_acquire) &&
+                    position == this->tail.load(std::memory_order_acquire)
+                ){
+                    this->ended = true;
+                    return false;
+                }
+                std::this_thread::yield();
+            }
+            record = this->ring[position & (ring_records - 1)];
+            this->head.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// \return true once pop() has reached the end of the trace
+        inline bool has_ended() const
+        {
+            return this->ended;
+        }
+
+        /// \return The index in the trace of the next record pop() will
+        /// return, which can be given to open() to resume from there
+        inline unsigned long tell() const
+        {
+            return this->first_record + this->head.load(std::memory_order_relaxed);
+        }
+
+        /// \return The file given to open()
+        inline const std::string& get_filename() const
+        {
+            return this->filename;
+        }
+
+    protected:
+
+        /// Number of records in the ring, a power of 2
+        static const unsigned long ring_records = 8192;
+
+        /// Body of the background thread
+        void fill();
+
+        /// Wait until half of the ring is free.
+        /// \return false if close() was called in the meantime
+        bool wait_for_space();
+
+        /// Decoded records, written by the background thread at tail and
+        /// read by pop() at head
+        std::vector<trace_record> ring;
+
+        /// Records taken out of and put into the ring since open().  They
+        /// only ever grow, and are masked to index the ring.
+        std::atomic<unsigned long> head;
+        std::atomic<unsigned long> tail;
+
+        /// Set by the background thread once it has put the last record
+        /// into the ring
+        std::atomic<bool> finished;
+
+        /// Set by close() to stop the background thread
+        std::atomic<bool> stopping;
+
+        /// See has_ended()
+        bool ended;
+
+        /// The sources the background thread reads, one of which is open
+        std::ifstream text;
+        binary_trace_reader binary;
+
+        /// See get_filename()
+        std::string filename;
+
+        /// See open()
+        unsigned long first_record;
+
+        /// Runs fill() while a file is open
+        std::thread reader;
+
+};
+
+/// Write records in the binary format read by binary_trace_reader
+/// \return false if filename could not be written
+bool write_binary_trace
+(
+    /// [in] Path of the binary trace to create
+    const std::string& filename,
+    /// [in] The records to write, in order
+    const std::vector<trace_record>& records
+);
+
+/// \class trace
+/// A memory trace parsed into memory once so that it can be shared,
+/// read-only, by any number of \ref cpu "cpus", even ones in different
+/// simulations running on different threads.
+class trace
+{
+
+    public:
+
+        /// Creates an empty trace
+        trace();
+
+        /// Parse every access in filename, replacing the current contents.
+        /// Like \ref cpu when it streams a trace, a last line with no
+        /// newline after it is dropped.  Binary traces (see
+        /// binary_trace_reader) are decoded instead.
+        /// \return false if the file could not be opened
+        bool load
+        (
+            /// [in] Path of a text trace
+            const std::string& filename
+        );
+
+        /// \return The number of accesses in the trace
+        inline unsigned long size() const
+        {
+            return this->records.size();
+        }
+
+        /// \return The access at index ix, which must be less than size()
+        inline const trace_record& operator[](unsigned long ix) const
+        {
+            return this->records[ix];
+        }
+
+        /// \return Every access in the trace, in order
+        inline const std::vector<trace_record>& get_records() const
+        {
+            return this->records;
+        }
+
+        /// \return The file given to load()
+        inline const std::string& get_filename() const
+        {
+            return this->filename;
+        }
+
+    protected:
+
+        /// Every access in the trace, in order
+        std::vector<trace_record> records;
+
+        /// See get_filename()
+        std::string filename;
+
+};
+
+#endif // header guard
@@ -0,0 +1,74 @@
+/// \file
+/// Project:                HMC Migration Simulator \n
+/// File Name:              trace_convert.cpp \n
+/// Date created:           Oct 17 2026 \n
+/// Engineers:              Khalique Ahmed
+///                         Conor Gardner
+///                         Dong Kai Wang\n
+/// Compilers:              g++, vc++ \n
+/// Target OS:              Ubuntu Linux 14.04
+///							Windows 7 \n
+/// Target architecture:    x86_64 */
+
+// Convert a text memory trace into the binary format read by
+// binary_trace_reader.  Any layout parse_trace_line() understands can be
+// converted, including the PARSEC traces which put a thread and a time
+// before each access.  Dependency hints and compute gaps are kept.  A
+// binary trace can be given anywhere a text trace can.
+//
+// Usage:
+//     trace_convert <text trace> <binary trace>
+
+#include <iostream>
+#include <vector>
+#include "trace.h"
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+
+	if (argc != 3)
+	{
+		cerr << "Usage: " << argv[0] << " <text trace> <binary trace>" << endl;
+		return -1;
+	}
+
+	trace text;
+	if (!text.load(argv[1]))
+		return -1;
+	if (!write_binary_trace(argv[2], text.get_records()))
+		return -1;
+
+	// read the result back to make sure it decodes to the same accesses
+	binary_trace_reader reader;
+	if (!reader.open(argv[2]) || reader.size() != text.size())
+	{
+		cerr << "Error. " << argv[2] << " did not read back correctly" << endl;
+		return -1;
+	}
+	vector<trace_record> decoded(text.size());
+	if (reader.read(decoded.data(), decoded.size()) != decoded.size())
+	{
+		cerr << "Error. " << argv[2] << " is truncated" << endl;
+		return -1;
+	}
+	for (unsigned long ix = 0; ix < decoded.size(); ix++)
+	{
+		if
+		(
+			decoded[ix].address != text[ix].address ||
+			decoded[ix].rw != text[ix].rw ||
+			decoded[ix].depends != text[ix].depends ||
+			decoded[ix].gap != text[ix].gap
+		)
+		{
+			cerr << "Error. Record " << ix << " of " << argv[2] << " did not read back correctly" << endl;
+			return -1;
+		}
+	}
+
+	cout << "Converted " << text.size() << " accesses from " << argv[1] << " to " << argv[2] << endl;
+	return 0;
+
+}